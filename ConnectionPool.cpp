@@ -0,0 +1,87 @@
+#include "ConnectionPool.h"
+#include <iostream>
+
+ConnectionPool::ConnectionPool(const std::string &path, size_t maxConnections, Initializer initializer)
+    : path(path), maxConnections(maxConnections ? maxConnections : 1), initializer(std::move(initializer)) {
+    // Every connection to ":memory:" is a separate database
+    if (path == ":memory:") {
+        this->maxConnections = 1;
+    }
+}
+
+ConnectionPool::~ConnectionPool() {
+    for (sqlite3 *db : all) {
+        sqlite3_close_v2(db);
+    }
+}
+
+// Open a connection for exclusive use by one thread at a time
+sqlite3 *ConnectionPool::open() {
+    sqlite3 *db = nullptr;
+    int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX;
+    if (sqlite3_open_v2(path.c_str(), &db, flags, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to open database: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_close(db);
+        return nullptr;
+    }
+    sqlite3_busy_timeout(db, 5000);
+    if (initializer) {
+        initializer(db);
+    }
+    return db;
+}
+
+sqlite3 *ConnectionPool::retain() {
+    std::thread::id self = std::this_thread::get_id();
+    std::unique_lock<std::mutex> lock(mutex);
+
+    auto current = held.find(self);
+    if (current != held.end()) {
+        ++current->second.depth;
+        return current->second.db;
+    }
+
+    while (idle.empty() && all.size() + opening >= maxConnections) {
+        available.wait(lock);
+    }
+
+    sqlite3 *db = nullptr;
+    if (!idle.empty()) {
+        db = idle.back();
+        idle.pop_back();
+    } else {
+        ++opening; // Reserve the slot while opening unlocked
+        lock.unlock();
+        db = open();
+        lock.lock();
+        --opening;
+        if (!db) {
+            available.notify_one();
+            return nullptr;
+        }
+        all.push_back(db);
+    }
+
+    held[self] = Held{db, 1};
+    return db;
+}
+
+void ConnectionPool::release() {
+    std::thread::id self = std::this_thread::get_id();
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto current = held.find(self);
+    if (current == held.end()) {
+        return;
+    }
+    if (--current->second.depth == 0) {
+        idle.push_back(current->second.db);
+        held.erase(current);
+        available.notify_one();
+    }
+}
+
+ConnectionPool::Lease ConnectionPool::acquire() {
+    sqlite3 *db = retain();
+    return Lease(db ? this : nullptr, db);
+}
@@ -0,0 +1,76 @@
+#ifndef CONNECTIONPOOL_H
+#define CONNECTIONPOOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sqlite3.h>
+
+// Hands out SQLite connections to concurrent callers.
+// Each connection is used by one thread at a time. A thread that already
+// holds a connection gets the same one back from nested acquire() calls, so
+// a transaction opened by an outer call covers the inner ones as well.
+class ConnectionPool {
+public:
+    // Called once for every newly opened connection (pragmas, hooks, ...)
+    using Initializer = std::function<void(sqlite3 *)>;
+
+    ConnectionPool(const std::string &path, size_t maxConnections, Initializer initializer = nullptr);
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool &) = delete;
+    ConnectionPool &operator=(const ConnectionPool &) = delete;
+
+    // A connection borrowed for the current scope
+    class Lease {
+    public:
+        Lease() : pool(nullptr), db(nullptr) {} // On nullptr, for a database that isn't open
+        Lease(Lease &&other) noexcept : pool(other.pool), db(other.db) { other.pool = nullptr; }
+        Lease &operator=(Lease &&) = delete;
+        ~Lease() { if (pool) pool->release(); }
+
+        sqlite3 *get() const { return db; }
+        operator sqlite3 *() const { return db; }
+
+    private:
+        friend class ConnectionPool;
+        Lease(ConnectionPool *pool, sqlite3 *db) : pool(pool), db(db) {}
+
+        ConnectionPool *pool;
+        sqlite3 *db;
+    };
+
+    // Borrow a connection, waiting if all of them are busy. Returns a lease
+    // on nullptr if a new connection could not be opened.
+    Lease acquire();
+
+    // Keep the calling thread's connection across calls (e.g. while a
+    // transaction is open); every retain() needs a matching release()
+    sqlite3 *retain();
+    void release();
+
+private:
+    struct Held {
+        sqlite3 *db;
+        size_t depth;
+    };
+
+    sqlite3 *open();
+
+    std::string path;
+    size_t maxConnections;
+    Initializer initializer;
+
+    std::mutex mutex;
+    std::condition_variable available;
+    std::vector<sqlite3 *> idle;
+    std::vector<sqlite3 *> all;
+    size_t opening = 0;
+    std::unordered_map<std::thread::id, Held> held;
+};
+
+#endif // CONNECTIONPOOL_H
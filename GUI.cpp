@@ -0,0 +1,195 @@
+#include "GUI.h"
+#include <optional>
+#include <string>
+#include <thread>
+
+// Helper function to copy text to clipboard
+void copy_to_clipboard(GtkWidget *widget, gpointer user_data) {
+    const char *text = static_cast<const char *>(user_data);
+    GtkClipboard *clipboard = gtk_clipboard_get(GDK_SELECTION_CLIPBOARD);
+    gtk_clipboard_set_text(clipboard, text, -1);
+}
+
+// Helper function to create a selectable label
+GtkWidget* create_selectable_label(const char* text) {
+    GtkWidget *label = gtk_label_new(text);
+    gtk_label_set_selectable(GTK_LABEL(label), TRUE); // Enable text selection
+    return label;
+}
+
+// Result of a background recipe load, handed back to the main loop
+struct RecipeViewer::PendingLoad {
+    RecipeViewer *viewer;
+    std::weak_ptr<bool> alive;
+    unsigned generation;
+    std::optional<Recipe> recipe;
+};
+
+RecipeViewer::RecipeViewer(RecipeManager &manager)
+    : manager(manager), alive(std::make_shared<bool>(true)) {}
+
+RecipeViewer::~RecipeViewer() {
+    alive.reset();
+    if (window) {
+        g_signal_handlers_disconnect_by_func(window, (gpointer)on_window_destroyed, this);
+        gtk_widget_destroy(window);
+    }
+}
+
+// Build the window once; later recipes only swap label text
+void RecipeViewer::build() {
+    window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+    gtk_window_set_title(GTK_WINDOW(window), "Recipe Viewer");
+    gtk_window_set_default_size(GTK_WINDOW(window), 400, 300);
+    g_signal_connect(window, "delete-event", G_CALLBACK(gtk_widget_hide_on_delete), NULL);
+    g_signal_connect(window, "destroy", G_CALLBACK(on_window_destroyed), this);
+
+    GtkWidget *scrolledWindow = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolledWindow), GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+    gtk_container_add(GTK_CONTAINER(window), scrolledWindow);
+
+    GtkWidget *grid = gtk_grid_new();
+    gtk_grid_set_row_spacing(GTK_GRID(grid), 10);
+    gtk_container_add(GTK_CONTAINER(scrolledWindow), grid);
+
+    nameLabel = create_selectable_label("");
+    gtk_label_set_xalign(GTK_LABEL(nameLabel), 0);
+    gtk_grid_attach(GTK_GRID(grid), nameLabel, 0, 0, 2, 1);
+
+    categoryLabel = create_selectable_label("");
+    gtk_label_set_xalign(GTK_LABEL(categoryLabel), 0);
+    gtk_grid_attach(GTK_GRID(grid), categoryLabel, 0, 1, 2, 1);
+
+    ingredientsLabel = create_selectable_label("");
+    gtk_label_set_xalign(GTK_LABEL(ingredientsLabel), 0);
+    gtk_label_set_line_wrap(GTK_LABEL(ingredientsLabel), TRUE);
+    gtk_label_set_max_width_chars(GTK_LABEL(ingredientsLabel), 60);
+    gtk_grid_attach(GTK_GRID(grid), ingredientsLabel, 0, 2, 2, 1);
+
+    spinner = gtk_spinner_new();
+    gtk_grid_attach(GTK_GRID(grid), spinner, 0, 3, 2, 1);
+
+    instructionsLabel = create_selectable_label("");
+    gtk_label_set_xalign(GTK_LABEL(instructionsLabel), 0);
+    gtk_label_set_line_wrap(GTK_LABEL(instructionsLabel), TRUE);
+    gtk_label_set_max_width_chars(GTK_LABEL(instructionsLabel), 60);
+    gtk_grid_attach(GTK_GRID(grid), instructionsLabel, 0, 4, 2, 1);
+
+    GtkWidget *buttonCopyName = gtk_button_new_with_label("Copy Name");
+    g_signal_connect(buttonCopyName, "clicked", G_CALLBACK(on_copy_name), this);
+    gtk_grid_attach(GTK_GRID(grid), buttonCopyName, 0, 5, 1, 1);
+
+    GtkWidget *buttonCopyInstructions = gtk_button_new_with_label("Copy Instructions");
+    g_signal_connect(buttonCopyInstructions, "clicked", G_CALLBACK(on_copy_instructions), this);
+    gtk_grid_attach(GTK_GRID(grid), buttonCopyInstructions, 1, 5, 1, 1);
+
+    gtk_widget_show_all(scrolledWindow);
+}
+
+// Copy the current recipe into the reused widgets
+void RecipeViewer::setContent() {
+    gtk_label_set_text(GTK_LABEL(nameLabel), ("Name: " + current.name).c_str());
+    gtk_label_set_text(GTK_LABEL(categoryLabel), ("Category: " + current.category).c_str());
+    gtk_widget_set_visible(categoryLabel, !current.category.empty());
+
+    std::string ingredients;
+    for (const auto &ingredient : current.ingredients) {
+        ingredients += (ingredients.empty() ? "" : ", ") + ingredient;
+    }
+    gtk_label_set_text(GTK_LABEL(ingredientsLabel), ("Ingredients: " + ingredients).c_str());
+    gtk_widget_set_visible(ingredientsLabel, !current.ingredients.empty());
+
+    gtk_label_set_text(GTK_LABEL(instructionsLabel), ("Instructions: " + current.instructions).c_str());
+}
+
+void RecipeViewer::show(const Recipe &recipe, GtkWindow *parent) {
+    if (!window) {
+        build();
+    }
+    ++generation;
+    current = recipe;
+
+    bool needsFetch = current.instructions.empty() && current.id > 0;
+    if (needsFetch) {
+        current.instructions = "Loading...";
+    }
+    setContent();
+
+    if (needsFetch) {
+        gtk_widget_show(spinner);
+        gtk_spinner_start(GTK_SPINNER(spinner));
+        loadRecipeAsync(current.id);
+    } else {
+        gtk_spinner_stop(GTK_SPINNER(spinner));
+        gtk_widget_hide(spinner);
+    }
+
+    if (parent) {
+        gtk_window_set_transient_for(GTK_WINDOW(window), parent);
+    }
+    gtk_window_present(GTK_WINDOW(window));
+}
+
+// Load the whole recipe off the main thread and post it back via the main loop
+void RecipeViewer::loadRecipeAsync(int recipeID) {
+    auto *pending = new PendingLoad{this, alive, generation, std::nullopt};
+    RecipeManager *source = &manager;
+    std::thread([pending, source, recipeID] {
+        pending->recipe = source->getRemoteRecipe(recipeID);
+        g_idle_add(on_recipe_loaded, pending);
+    }).detach();
+}
+
+gboolean RecipeViewer::on_recipe_loaded(gpointer data) {
+    std::unique_ptr<PendingLoad> pending(static_cast<PendingLoad *>(data));
+    if (pending->alive.expired()) {
+        return G_SOURCE_REMOVE;
+    }
+    RecipeViewer *viewer = pending->viewer;
+    if (!viewer->window || pending->generation != viewer->generation) {
+        return G_SOURCE_REMOVE; // A newer recipe replaced this one
+    }
+
+    if (pending->recipe) {
+        // Keep the thumbnail and favorite flag the caller passed in
+        const Recipe &loaded = *pending->recipe;
+        viewer->current.name = loaded.name.empty() ? viewer->current.name : loaded.name;
+        viewer->current.category = loaded.category;
+        viewer->current.ingredients = loaded.ingredients;
+        viewer->current.instructions = loaded.instructions;
+    } else {
+        viewer->current.instructions = "No instructions found.";
+    }
+    viewer->setContent();
+    gtk_spinner_stop(GTK_SPINNER(viewer->spinner));
+    gtk_widget_hide(viewer->spinner);
+    return G_SOURCE_REMOVE;
+}
+
+void RecipeViewer::on_copy_name(GtkWidget *widget, gpointer data) {
+    RecipeViewer *viewer = static_cast<RecipeViewer *>(data);
+    copy_to_clipboard(widget, (gpointer)viewer->current.name.c_str());
+}
+
+void RecipeViewer::on_copy_instructions(GtkWidget *widget, gpointer data) {
+    RecipeViewer *viewer = static_cast<RecipeViewer *>(data);
+    copy_to_clipboard(widget, (gpointer)viewer->current.instructions.c_str());
+}
+
+// The window can be destroyed with its parent; rebuild it on the next show()
+void RecipeViewer::on_window_destroyed(GtkWidget *widget, gpointer data) {
+    RecipeViewer *viewer = static_cast<RecipeViewer *>(data);
+    viewer->window = nullptr;
+    viewer->nameLabel = nullptr;
+    viewer->categoryLabel = nullptr;
+    viewer->ingredientsLabel = nullptr;
+    viewer->instructionsLabel = nullptr;
+    viewer->spinner = nullptr;
+}
+
+// Show a recipe in the application's shared viewer window
+void RecipeManager::displayRecipeUI(const Recipe& recipe) {
+    // Intentionally never destroyed: it must not outlive GTK at static teardown
+    static RecipeViewer *viewer = new RecipeViewer(*this);
+    viewer->show(recipe);
+}
@@ -0,0 +1,56 @@
+#ifndef GUI_H
+#define GUI_H
+
+#include <gtk/gtk.h>
+#include <memory>
+#include "RecipeManager.h"
+
+// Helper function to copy text to clipboard
+void copy_to_clipboard(GtkWidget *widget, gpointer user_data);
+
+// Helper function to create a selectable label
+GtkWidget* create_selectable_label(const char* text);
+
+// Recipe detail view hosted by the running GtkApplication.
+// The window and its widgets are built once and reused for every recipe;
+// closing the window only hides it. Must be used from the GTK main thread.
+class RecipeViewer {
+public:
+    explicit RecipeViewer(RecipeManager &manager);
+    ~RecipeViewer();
+
+    RecipeViewer(const RecipeViewer &) = delete;
+    RecipeViewer &operator=(const RecipeViewer &) = delete;
+
+    // Show a recipe right away; if it has an API id but no instructions, the
+    // whole recipe is loaded on a worker thread and every field is filled
+    // in when it arrives
+    void show(const Recipe &recipe, GtkWindow *parent = nullptr);
+
+private:
+    struct PendingLoad;
+
+    void build();
+    void setContent();
+    void loadRecipeAsync(int recipeID);
+
+    static void on_copy_name(GtkWidget *widget, gpointer data);
+    static void on_copy_instructions(GtkWidget *widget, gpointer data);
+    static void on_window_destroyed(GtkWidget *widget, gpointer data);
+    static gboolean on_recipe_loaded(gpointer data);
+
+    RecipeManager &manager;
+    Recipe current; // Owned copy; clipboard buttons read from here
+
+    GtkWidget *window = nullptr;
+    GtkWidget *nameLabel = nullptr;
+    GtkWidget *categoryLabel = nullptr;
+    GtkWidget *ingredientsLabel = nullptr;
+    GtkWidget *instructionsLabel = nullptr;
+    GtkWidget *spinner = nullptr;
+
+    unsigned generation = 0;        // Bumped per show(); stale loads are dropped
+    std::shared_ptr<bool> alive;    // Lets late worker results detect destruction
+};
+
+#endif // GUI_H
@@ -0,0 +1,535 @@
+#include "ImportPipeline.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Consecutive array elements (or lines), handed to one worker with a copy
+// of their bytes
+struct Chunk {
+    size_t index;
+    uint64_t firstByte; // File offset of bytes[0]
+    std::string bytes;
+    std::vector<std::pair<size_t, size_t>> spans; // Element ranges in bytes
+};
+
+// The input not yet handed out in chunks, read in fixed-size windows so
+// memory does not grow with the file
+struct Window {
+    std::istream &input;
+    size_t readBytes;
+    uint64_t start;    // File offset of bytes[0]
+    std::string bytes;
+
+    // Drop the first `used` bytes and append the next window; false at the
+    // end of the input
+    bool refill(size_t used) {
+        bytes.erase(0, used);
+        start += used;
+        size_t kept = bytes.size();
+        bytes.resize(kept + readBytes);
+        input.read(&bytes[kept], static_cast<std::streamsize>(readBytes));
+        bytes.resize(kept + static_cast<size_t>(input.gcount()));
+        return bytes.size() > kept;
+    }
+};
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Trim ingredients and drop empty ones
+void normalizeIngredients(std::vector<std::string> &ingredients) {
+    size_t kept = 0;
+    for (std::string &ingredient : ingredients) {
+        size_t start = 0;
+        size_t end = ingredient.size();
+        while (start < end && isSpace(ingredient[start])) {
+            ++start;
+        }
+        while (end > start && isSpace(ingredient[end - 1])) {
+            --end;
+        }
+        if (start < end) {
+            ingredient.erase(end);
+            ingredient.erase(0, start);
+            ingredients[kept++].swap(ingredient);
+        }
+    }
+    ingredients.resize(kept);
+}
+
+// Advance i past white space, reading further windows as needed
+void skipSpace(Window &window, size_t &i) {
+    for (;;) {
+        while (i < window.bytes.size() && isSpace(window.bytes[i])) {
+            ++i;
+        }
+        if (i < window.bytes.size()) {
+            return;
+        }
+        bool more = window.refill(i);
+        i = 0;
+        if (!more) {
+            return;
+        }
+    }
+}
+
+// Copy the elements of a finished chunk out of the window
+Chunk takeChunk(size_t index, const Window &window, size_t chunkStart, size_t chunkEnd, std::vector<std::pair<size_t, size_t>> &spans) {
+    Chunk chunk{index, window.start + chunkStart, window.bytes.substr(chunkStart, chunkEnd - chunkStart), {}};
+    chunk.spans.swap(spans);
+    return chunk;
+}
+
+// Find the top-level array elements of a JSON document without parsing them.
+// Only string, bracket and comma positions are tracked; each element's own
+// syntax is checked when a worker parses it. emit returns false to stop.
+// With afterElement the input continues an array after one of its elements,
+// so it must start with ',' or ']'.
+bool scanArray(Window &window, size_t chunkBytes, bool afterElement, const std::function<bool(Chunk &&)> &emit, std::string &error) {
+    const std::string &text = window.bytes;
+    size_t i = 0;
+    skipSpace(window, i);
+    if (afterElement) {
+        if (i == text.size() || (text[i] != ',' && text[i] != ']')) {
+            error = "expected ',' or ']' at byte " + std::to_string(window.start + i);
+            return false;
+        }
+        i += text[i] == ',' ? 1 : 0;
+    } else {
+        while (text.size() - i < 4 && window.refill(0)) {
+            // Read on until "null" can be compared
+        }
+        if (text.compare(i, 4, "null") == 0) {
+            return true; // Empty export from older versions
+        }
+        if (i == text.size() || text[i] != '[') {
+            error = "expected a JSON array";
+            return false;
+        }
+        ++i;
+    }
+
+    // Positions are relative to the window and move when it is refilled;
+    // spans are relative to chunkStart
+    size_t index = 0;
+    std::vector<std::pair<size_t, size_t>> spans;
+    size_t chunkStart = 0;
+    size_t elementStart = std::string::npos;
+    size_t depth = 0;
+    bool inString = false;
+    bool escaped = false;
+    bool closed = false;
+    for (; !closed; ++i) {
+        if (i == text.size()) {
+            size_t used = !spans.empty() ? chunkStart : elementStart != std::string::npos ? elementStart : i;
+            if (!window.refill(used)) {
+                break;
+            }
+            i -= used;
+            chunkStart -= std::min(chunkStart, used);
+            if (elementStart != std::string::npos) {
+                elementStart -= used;
+            }
+        }
+        char c = text[i];
+        if (inString) {
+            if (escaped) {
+                escaped = false;
+            } else if (c == '\\') {
+                escaped = true;
+            } else if (c == '"') {
+                inString = false;
+            }
+            continue;
+        }
+        if (elementStart == std::string::npos && !isSpace(c) && c != ',' && !(depth == 0 && c == ']')) {
+            elementStart = i;
+        }
+        switch (c) {
+        case '"':
+            inString = true;
+            break;
+        case '{':
+        case '[':
+            ++depth;
+            break;
+        case '}':
+        case ']':
+            if (depth > 0) {
+                --depth;
+                break;
+            }
+            if (c == '}') {
+                error = "unbalanced '}' at byte " + std::to_string(window.start + i);
+                return false;
+            }
+            closed = true;
+            [[fallthrough]]; // The closing bracket also ends the last element
+        case ',':
+            if (depth > 0) {
+                break;
+            }
+            if (elementStart == std::string::npos) {
+                if (c == ',' || !spans.empty() || index > 0) {
+                    error = "empty array element at byte " + std::to_string(window.start + i);
+                    return false;
+                }
+                break; // "[]"
+            }
+            if (spans.empty()) {
+                chunkStart = elementStart;
+            }
+            spans.emplace_back(elementStart - chunkStart, i - chunkStart);
+            elementStart = std::string::npos;
+            if (i - chunkStart >= chunkBytes || closed) {
+                if (!emit(takeChunk(index++, window, chunkStart, i, spans))) {
+                    return false;
+                }
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    skipSpace(window, i);
+    if (!closed || i != text.size()) {
+        error = closed ? "unexpected data after the array" : "unterminated array";
+        return false;
+    }
+    return true;
+}
+
+// Find the non-blank lines of an NDJSON document. A last line without a
+// newline may still be being written, so it is left out unless it is
+// complete JSON; endByte is set to the file offset after the last line taken.
+bool scanLines(Window &window, size_t chunkBytes, const std::function<bool(Chunk &&)> &emit, uint64_t &endByte) {
+    const std::string &text = window.bytes;
+    size_t index = 0;
+    std::vector<std::pair<size_t, size_t>> spans;
+    size_t chunkStart = 0;
+    size_t start = 0;
+    size_t searched = 0;
+    bool atEnd = false;
+    for (;;) {
+        const char *newline = static_cast<const char *>(std::memchr(text.data() + searched, '\n', text.size() - searched));
+        if (!newline && !atEnd) {
+            size_t used = spans.empty() ? start : chunkStart;
+            searched = text.size() - used;
+            atEnd = !window.refill(used);
+            start -= used;
+            chunkStart -= std::min(chunkStart, used);
+            continue;
+        }
+        size_t end = newline ? static_cast<size_t>(newline - text.data()) : text.size();
+        size_t first = start;
+        while (first < end && isSpace(text[first])) {
+            ++first;
+        }
+        bool unfinished = !newline && first < end && !nlohmann::json::accept(text.begin() + start, text.begin() + end);
+        if (first < end && !unfinished) {
+            if (spans.empty()) {
+                chunkStart = start;
+            }
+            spans.emplace_back(start - chunkStart, end - chunkStart);
+        }
+        if (!unfinished) {
+            start = newline ? end + 1 : end;
+        }
+        searched = start;
+        bool last = !newline;
+        if (!spans.empty() && (end - chunkStart >= chunkBytes || last)) {
+            if (!emit(takeChunk(index++, window, chunkStart, end, spans))) {
+                return false;
+            }
+        }
+        if (last) {
+            endByte = window.start + start;
+            return true;
+        }
+    }
+}
+
+// Split the input into chunks of whole recipes
+bool scan(Window &window, ImportPipeline::Layout layout, const ImportPipeline::Options &options, const std::function<bool(Chunk &&)> &emit, uint64_t &endByte, std::string &error) {
+    if (layout == ImportPipeline::Layout::Lines) {
+        return scanLines(window, options.chunkBytes, emit, endByte);
+    }
+    bool ok = scanArray(window, options.chunkBytes, options.afterElement, emit, error);
+    endByte = window.start + window.bytes.size();
+    return ok;
+}
+
+// Normalize the recipe and fill in its stored values
+void finishRecipe(PreparedRecipe &prepared) {
+    Recipe &recipe = prepared.recipe;
+    normalizeIngredients(recipe.ingredients);
+    prepared.ingredients = joinIngredients(recipe.ingredients);
+    prepared.nameKey = recipeNameKey(recipe.name);
+    prepared.hash = recipeContentHash(recipe.name, prepared.ingredients, recipe.category, recipe.instructions,
+                                      recipe.isFavorite);
+}
+
+// Parse and prepare the elements of a chunk
+bool parseChunk(const Chunk &chunk, std::vector<PreparedRecipe> &recipes, std::string &error) {
+    const std::string &text = chunk.bytes;
+    recipes.clear();
+    recipes.reserve(chunk.spans.size());
+    for (const auto &span : chunk.spans) {
+        nlohmann::json recipeJson = nlohmann::json::parse(text.begin() + span.first, text.begin() + span.second,
+                                                          nullptr, false);
+        std::string recipeError = recipeJson.is_discarded() ? "invalid JSON" : "";
+        recipes.emplace_back();
+        if (!recipeError.empty() || !prepareRecipe(recipeJson, recipes.back(), recipeError)) {
+            error = "recipe at byte " + std::to_string(chunk.firstByte + span.first) + ": " + recipeError;
+            return false;
+        }
+        recipes.back().sourceEnd = chunk.firstByte + span.second;
+    }
+    return true;
+}
+
+} // namespace
+
+bool prepareRecipe(const nlohmann::json &recipeJson, PreparedRecipe &prepared, std::string &error) {
+    if (!recipeJson.is_object()) {
+        error = "recipe is not an object";
+        return false;
+    }
+    auto text = [&](const char *field, std::string &out, bool required) {
+        auto value = recipeJson.find(field);
+        if (value == recipeJson.end() || value->is_null()) {
+            if (required) {
+                error = std::string("missing ") + field;
+            }
+            return !required;
+        }
+        if (!value->is_string()) {
+            error = std::string(field) + " is not a string";
+            return false;
+        }
+        out = value->get<std::string>();
+        return true;
+    };
+
+    Recipe &recipe = prepared.recipe;
+    if (!text("name", recipe.name, true) || !text("category", recipe.category, true) ||
+        !text("instructions", recipe.instructions, false)) {
+        return false;
+    }
+
+    auto ingredients = recipeJson.find("ingredients");
+    if (ingredients == recipeJson.end() || !ingredients->is_array()) {
+        error = "ingredients is not an array";
+        return false;
+    }
+    recipe.ingredients.clear();
+    for (const auto &ingredient : *ingredients) {
+        if (!ingredient.is_string()) {
+            error = "ingredient is not a string";
+            return false;
+        }
+        recipe.ingredients.push_back(ingredient.get<std::string>());
+    }
+
+    auto favorite = recipeJson.find("favorite");
+    recipe.isFavorite = favorite != recipeJson.end() &&
+                        (favorite->is_boolean() ? favorite->get<bool>() : favorite->is_number() && favorite->get<double>() != 0);
+
+    finishRecipe(prepared);
+    if (prepared.nameKey.empty()) {
+        error = "recipe name is empty";
+        return false;
+    }
+    return true;
+}
+
+PreparedRecipe prepareRecipe(const Recipe &recipe) {
+    PreparedRecipe prepared;
+    prepared.recipe = recipe;
+    finishRecipe(prepared);
+    return prepared;
+}
+
+ImportPipeline::ImportPipeline(const Options &options) : options(options) {
+    if (this->options.threads == 0) {
+        this->options.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (this->options.chunkBytes == 0) {
+        this->options.chunkBytes = 1;
+    }
+    if (this->options.maxChunksInFlight == 0) {
+        this->options.maxChunksInFlight = 4 * this->options.threads;
+    }
+}
+
+bool ImportPipeline::run(std::istream &input, Layout layout, const Consumer &consumer, uint64_t *endOffset) {
+    uint64_t endByte = options.firstByte;
+    bool ok = options.threads == 1 ? runInline(input, layout, consumer, endByte) : runParallel(input, layout, consumer, endByte);
+    if (ok && endOffset) {
+        *endOffset = endByte;
+    }
+    return ok;
+}
+
+bool ImportPipeline::runParallel(std::istream &input, Layout layout, const Consumer &consumer, uint64_t &endByte) {
+
+    std::mutex mutex;
+    std::condition_variable workReady;   // Scanner -> workers
+    std::condition_variable resultReady; // Workers -> writer
+    std::condition_variable spaceReady;  // Writer -> scanner
+    std::deque<Chunk> pending;
+    std::map<size_t, std::vector<PreparedRecipe>> parsed;
+    size_t scanned = 0;
+    size_t written = 0;
+    bool scanDone = false;
+    bool stop = false;
+    std::string error;
+
+    auto fail = [&](const std::string &message) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!stop) {
+            error = message;
+            stop = true;
+        }
+        workReady.notify_all();
+        resultReady.notify_all();
+        spaceReady.notify_all();
+    };
+
+    std::thread scanner([&] {
+        std::string scanError;
+        Window window{input, options.chunkBytes, options.firstByte, {}};
+        bool ok = scan(window, layout, options, [&](Chunk &&chunk) {
+            std::unique_lock<std::mutex> lock(mutex);
+            spaceReady.wait(lock, [&] { return stop || scanned - written < options.maxChunksInFlight; });
+            if (stop) {
+                return false;
+            }
+            pending.push_back(std::move(chunk));
+            ++scanned;
+            workReady.notify_one();
+            return true;
+        }, endByte, scanError);
+
+        if (!ok && !scanError.empty()) {
+            fail(scanError);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        scanDone = true;
+        workReady.notify_all();
+        resultReady.notify_all();
+    });
+
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < options.threads; ++t) {
+        workers.emplace_back([&] {
+            for (;;) {
+                Chunk chunk;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    workReady.wait(lock, [&] { return stop || scanDone || !pending.empty(); });
+                    if (stop || pending.empty()) {
+                        return;
+                    }
+                    chunk = std::move(pending.front());
+                    pending.pop_front();
+                }
+
+                std::vector<PreparedRecipe> recipes;
+                std::string chunkError;
+                if (!parseChunk(chunk, recipes, chunkError)) {
+                    fail(chunkError);
+                    return;
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                parsed.emplace(chunk.index, std::move(recipes));
+                resultReady.notify_all();
+            }
+        });
+    }
+
+    // Write on the calling thread, strictly in file order
+    for (;;) {
+        std::vector<PreparedRecipe> recipes;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            resultReady.wait(lock, [&] {
+                return stop || parsed.count(written) || (scanDone && written == scanned);
+            });
+            auto next = parsed.find(written);
+            if (stop || next == parsed.end()) {
+                break;
+            }
+            recipes = std::move(next->second);
+            parsed.erase(next);
+        }
+
+        bool consumed = true;
+        for (PreparedRecipe &recipe : recipes) {
+            if (!consumer(std::move(recipe))) {
+                consumed = false;
+                break;
+            }
+        }
+        if (!consumed) {
+            fail("");
+            break;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        ++written;
+        spaceReady.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+        workReady.notify_all();
+        spaceReady.notify_all();
+    }
+    scanner.join();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    if (!error.empty()) {
+        std::cerr << "Failed to parse import file: " << error << std::endl;
+        return false;
+    }
+    return scanDone && written == scanned;
+}
+
+bool ImportPipeline::runInline(std::istream &input, Layout layout, const Consumer &consumer, uint64_t &endByte) {
+    std::string error;
+    std::vector<PreparedRecipe> recipes;
+    Window window{input, options.chunkBytes, options.firstByte, {}};
+    bool ok = scan(window, layout, options, [&](Chunk &&chunk) {
+        if (!parseChunk(chunk, recipes, error)) {
+            return false;
+        }
+        for (PreparedRecipe &recipe : recipes) {
+            if (!consumer(std::move(recipe))) {
+                return false;
+            }
+        }
+        return true;
+    }, endByte, error);
+
+    if (!error.empty()) {
+        std::cerr << "Failed to parse import file: " << error << std::endl;
+    }
+    return ok;
+}
@@ -0,0 +1,71 @@
+#ifndef IMPORTPIPELINE_H
+#define IMPORTPIPELINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <string>
+#include <nlohmann/json.hpp>
+#include "RecipeManager.h"
+
+// A validated recipe from an import file, with the values the writer needs
+struct PreparedRecipe {
+    Recipe recipe;
+    std::string ingredients; // Joined as stored in the database
+    std::string nameKey;
+    int64_t hash = 0;
+    uint64_t sourceEnd = 0; // File offset where the recipe ends (JSON and NDJSON)
+};
+
+// Validate one recipe object and normalize its ingredients (trimmed, empty
+// entries dropped). Returns false with a message in error if it is unusable.
+bool prepareRecipe(const nlohmann::json &recipeJson, PreparedRecipe &prepared, std::string &error);
+
+// Normalize a recipe the same way and fill in its stored values
+PreparedRecipe prepareRecipe(const Recipe &recipe);
+
+// Parallel parser for JSON and NDJSON import files.
+// A pre-scan on one thread reads the input in windows of chunkBytes and
+// splits the top-level array (or the lines) into chunks of whole elements;
+// worker threads parse, validate and normalize the chunks; the calling
+// thread receives the recipes in file order, so a single writer can keep its
+// transaction. A bounded number of chunks wait for the writer, so memory
+// stays near chunkBytes times maxChunksInFlight whatever the file size.
+class ImportPipeline {
+public:
+    struct Options {
+        size_t threads = 0;               // Parser threads; 0 = one per core, 1 = none
+        size_t chunkBytes = 256 * 1024;   // Input bytes per work item
+        size_t maxChunksInFlight = 0;     // Parsed chunks not yet written; 0 = 4 per thread
+        uint64_t firstByte = 0;           // File offset the input starts at
+        bool afterElement = false;        // Array input starts right after an element (a resumed read)
+    };
+
+    // Array: one JSON array of recipes. Lines: one recipe per line, blank
+    // lines ignored; a last line without a newline is left out unless it is
+    // complete JSON, as it may still be being written.
+    enum class Layout { Array, Lines };
+
+    // Called on the calling thread for each recipe; return false to stop
+    using Consumer = std::function<bool(PreparedRecipe &&)>;
+
+    explicit ImportPipeline(const Options &options);
+
+    // Parse recipes in the given layout from input, read from its current
+    // position to the end. Returns false if the input is malformed, a recipe
+    // is invalid or the consumer stopped; otherwise endOffset (if given) is
+    // set to the file offset after the last recipe read.
+    bool run(std::istream &input, Layout layout, const Consumer &consumer, uint64_t *endOffset = nullptr);
+
+private:
+    // Scanner, parser and writer threads
+    bool runParallel(std::istream &input, Layout layout, const Consumer &consumer, uint64_t &endByte);
+
+    // Same work on the calling thread alone
+    bool runInline(std::istream &input, Layout layout, const Consumer &consumer, uint64_t &endByte);
+
+    Options options;
+};
+
+#endif // IMPORTPIPELINE_H
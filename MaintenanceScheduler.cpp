@@ -0,0 +1,278 @@
+#include "MaintenanceScheduler.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+int64_t nowTicks() {
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+// Run a single-value PRAGMA and return its result (0 on failure)
+int pragmaValue(sqlite3 *db, const char *sql) {
+    sqlite3_stmt *stmt;
+    int value = 0;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            value = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    }
+    return value;
+}
+
+} // namespace
+
+MaintenanceScheduler::MaintenanceScheduler(ConnectionPool &pool, std::recursive_mutex &writeMutex, const Options &options)
+    : pool(pool), writeMutex(writeMutex), options(options), lastActivity(nowTicks()) {
+    using Clock = std::chrono::steady_clock;
+    tasks.push_back(Task{"vacuum", true, [this](sqlite3 *db, Clock::time_point deadline) { return vacuumSlice(db, deadline); }, {}, {}});
+    tasks.push_back(Task{"checkpoint", false, [this](sqlite3 *db, Clock::time_point) { return checkpointSlice(db); }, {}, {}});
+    tasks.push_back(Task{"optimize", true, [this](sqlite3 *db, Clock::time_point) { return optimizeSlice(db); }, {}, {}});
+    builtInTasks = tasks.size();
+    for (Task &task : tasks) {
+        task.status.name = task.name;
+    }
+}
+
+MaintenanceScheduler::~MaintenanceScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void MaintenanceScheduler::addTask(const std::string &name, bool writes, TaskFunction run) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Task task{name, writes, std::move(run), {}, {}};
+    task.status.name = name;
+    tasks.insert(tasks.end() - builtInTasks, std::move(task));
+}
+
+void MaintenanceScheduler::start() {
+    if (!worker.joinable()) {
+        worker = std::thread([this] { schedulerLoop(); });
+    }
+}
+
+void MaintenanceScheduler::noteActivity() {
+    lastActivity = nowTicks();
+    if (!active.exchange(true)) {
+        std::lock_guard<std::mutex> lock(mutex); // Don't slip between the check and the wait
+        changed.notify_all();
+    }
+}
+
+void MaintenanceScheduler::wake() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        woken = true;
+        for (Task &task : tasks) {
+            task.notBefore = {};
+        }
+    }
+    changed.notify_all();
+}
+
+void MaintenanceScheduler::setOptions(const Options &newOptions) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        options = newOptions;
+        woken = true;
+    }
+    changed.notify_all();
+}
+
+std::vector<MaintenanceScheduler::TaskStatus> MaintenanceScheduler::status() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<TaskStatus> result;
+    for (const Task &task : tasks) {
+        result.push_back(task.status);
+    }
+    return result;
+}
+
+bool MaintenanceScheduler::runNow() {
+    bool ok = true;
+    for (;;) {
+        std::chrono::steady_clock::time_point nextRetry;
+        bool more = runRound(true, nextRetry);
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const Task &task : tasks) {
+            ok = ok && task.status.ok;
+        }
+        if (!more || stopping) {
+            return ok;
+        }
+    }
+}
+
+void MaintenanceScheduler::schedulerLoop() {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point nextRetry = Clock::time_point::max();
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        // Something to do: a wake-up, use of the database since the last
+        // round (new churn), or a task that asked to be retried
+        auto due = [&] { return stopping || woken || active || Clock::now() >= nextRetry; };
+        if (nextRetry == Clock::time_point::max()) {
+            changed.wait(lock, due);
+        } else {
+            changed.wait_until(lock, nextRetry, due);
+        }
+
+        // ... but only once the application has been quiet for a while
+        for (;;) {
+            Clock::time_point quietAt = Clock::time_point(Clock::duration(lastActivity.load())) + options.idleAfter;
+            if (stopping || Clock::now() >= quietAt) {
+                break;
+            }
+            changed.wait_until(lock, quietAt, [this] { return stopping; });
+        }
+        if (stopping) {
+            break;
+        }
+
+        woken = false;
+        active = false;
+        lock.unlock();
+        bool more = runRound(false, nextRetry);
+        lock.lock();
+        woken = woken || more;
+    }
+}
+
+bool MaintenanceScheduler::runRound(bool force, std::chrono::steady_clock::time_point &nextRetry) {
+    using Clock = std::chrono::steady_clock;
+    std::lock_guard<std::mutex> round(roundMutex);
+    nextRetry = Clock::time_point::max();
+    bool more = false;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (size_t i = 0; i < tasks.size() && !stopping; ++i) {
+        Task &task = tasks[i];
+        Clock::time_point started = Clock::now();
+        if (started < task.notBefore) {
+            nextRetry = std::min(nextRetry, task.notBefore);
+            continue;
+        }
+        if (!force && active) {
+            more = true; // The application is busy again; continue later
+            break;
+        }
+        Clock::time_point deadline = started + options.sliceBudget;
+        lock.unlock();
+
+        Slice slice;
+        {
+            std::unique_lock<std::recursive_mutex> writeLock(writeMutex, std::defer_lock);
+            if (task.writes) {
+                writeLock.lock();
+            }
+            ConnectionPool::Lease db = pool.acquire();
+            if (db) {
+                slice = task.run(db, deadline);
+            } else {
+                slice.failed = true;
+                slice.detail = "no connection";
+            }
+        }
+
+        lock.lock();
+        Clock::time_point finished = Clock::now();
+        if (slice.worked || slice.failed) {
+            task.status.lastRun = std::chrono::system_clock::now();
+            task.status.lastDuration = std::chrono::duration_cast<std::chrono::microseconds>(finished - started);
+            task.status.ok = !slice.failed;
+            task.status.detail = slice.detail;
+            ++task.status.runs;
+        }
+        task.status.pending = slice.more;
+        if (slice.failed) {
+            std::cerr << "Failed to run maintenance task " << task.name << ": " << slice.detail << std::endl;
+        }
+        if (slice.retryIn.count() > 0) {
+            task.notBefore = finished + slice.retryIn;
+            nextRetry = std::min(nextRetry, task.notBefore);
+        }
+        more = more || (slice.more && !slice.failed);
+    }
+    return more;
+}
+
+// Return free pages to the file system, a few at a time
+MaintenanceScheduler::Slice MaintenanceScheduler::vacuumSlice(sqlite3 *db, std::chrono::steady_clock::time_point deadline) {
+    Slice slice;
+    if (pragmaValue(db, "PRAGMA auto_vacuum;") != 2) {
+        slice.retryIn = std::chrono::hours(24); // Not an incremental database; its free pages are reused instead
+        return slice;
+    }
+
+    int before = pragmaValue(db, "PRAGMA freelist_count;");
+    int remaining = before;
+    while (remaining > 0 && std::chrono::steady_clock::now() < deadline) {
+        if (sqlite3_exec(db, "PRAGMA incremental_vacuum(64);", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            slice.failed = true;
+            slice.detail = sqlite3_errmsg(db);
+            return slice;
+        }
+        remaining = pragmaValue(db, "PRAGMA freelist_count;");
+    }
+    slice.worked = remaining < before;
+    slice.more = remaining > 0;
+    slice.detail = "returned " + std::to_string(before - remaining) + " pages, " + std::to_string(remaining) + " left";
+    return slice;
+}
+
+// Copy WAL frames into the database without blocking anyone, and reset a
+// large WAL file once everything in it has been copied
+MaintenanceScheduler::Slice MaintenanceScheduler::checkpointSlice(sqlite3 *db) {
+    Slice slice;
+    int logFrames = 0;
+    int copied = 0;
+    if (sqlite3_wal_checkpoint_v2(db, nullptr, SQLITE_CHECKPOINT_PASSIVE, &logFrames, &copied) != SQLITE_OK) {
+        slice.failed = true;
+        slice.detail = sqlite3_errmsg(db);
+        return slice;
+    }
+    if (logFrames <= 0) {
+        return slice; // Not in WAL mode, or nothing written since the last reset
+    }
+
+    slice.worked = true;
+    slice.detail = "copied " + std::to_string(copied) + " of " + std::to_string(logFrames) + " frames";
+    if (copied < logFrames) {
+        slice.retryIn = std::chrono::seconds(5); // A reader still needs the old frames
+    } else if (logFrames >= options.checkpointPages) {
+        // Nothing left to copy, so this only waits for readers: don't let it
+        // hold up writers for the busy timeout
+        sqlite3_busy_timeout(db, 0);
+        if (sqlite3_wal_checkpoint_v2(db, nullptr, SQLITE_CHECKPOINT_TRUNCATE, nullptr, nullptr) == SQLITE_OK) {
+            slice.detail += ", truncated the WAL";
+        } else {
+            slice.retryIn = std::chrono::seconds(5);
+        }
+        sqlite3_busy_timeout(db, 5000);
+    }
+    return slice;
+}
+
+// Let SQLite refresh statistics it considers stale; analysis_limit keeps
+// the work bounded on large tables
+MaintenanceScheduler::Slice MaintenanceScheduler::optimizeSlice(sqlite3 *db) {
+    Slice slice;
+    if (sqlite3_exec(db, "PRAGMA analysis_limit = 400; PRAGMA optimize;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        slice.failed = true;
+        slice.detail = sqlite3_errmsg(db);
+        return slice;
+    }
+    slice.worked = true;
+    slice.detail = "ran PRAGMA optimize";
+    std::lock_guard<std::mutex> lock(mutex);
+    slice.retryIn = options.optimizeEvery;
+    return slice;
+}
@@ -0,0 +1,115 @@
+#ifndef MAINTENANCESCHEDULER_H
+#define MAINTENANCESCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sqlite3.h>
+#include "ConnectionPool.h"
+
+// Runs database upkeep on a background thread while the application is idle.
+// Nothing runs until no activity has been reported for Options::idleAfter.
+// Work is done in slices: each task does what fits in Options::sliceBudget,
+// and a slice that takes the write lock holds it for no longer than that, so
+// a user who comes back waits at most one slice. Built-in tasks return free
+// pages (incremental_vacuum), checkpoint the WAL and run PRAGMA optimize;
+// the owner adds its own tasks in front of them.
+class MaintenanceScheduler {
+public:
+    struct Options {
+        std::chrono::milliseconds idleAfter{2000};    // Quiet time before maintenance starts
+        std::chrono::milliseconds sliceBudget{50};    // Time one task may use per slice
+        int checkpointPages = 1000;                   // Truncate the WAL once it has this many pages
+        std::chrono::seconds optimizeEvery{600};      // Minimum time between PRAGMA optimize runs
+    };
+
+    // What one slice of a task did
+    struct Slice {
+        bool worked = false;              // Something was done; recorded in status()
+        bool more = false;                // Not finished: run again in the next slice
+        bool failed = false;
+        std::string detail;               // e.g. "deleted 2000 rows"
+        std::chrono::seconds retryIn{0};  // Nothing to do before then; 0 = after the next activity
+    };
+
+    // One slice of work on db; should return soon after deadline
+    using TaskFunction = std::function<Slice(sqlite3 *db, std::chrono::steady_clock::time_point deadline)>;
+
+    // Last run of one task
+    struct TaskStatus {
+        std::string name;
+        std::chrono::system_clock::time_point lastRun; // Epoch if it never did any work
+        std::chrono::microseconds lastDuration{0};
+        bool ok = true;
+        bool pending = false; // More work is waiting
+        std::string detail;
+        size_t runs = 0;
+    };
+
+    // Tasks that write take writeMutex before borrowing a connection, like
+    // every other writer of the pool
+    MaintenanceScheduler(ConnectionPool &pool, std::recursive_mutex &writeMutex, const Options &options);
+    ~MaintenanceScheduler(); // Stops after the current slice
+
+    MaintenanceScheduler(const MaintenanceScheduler &) = delete;
+    MaintenanceScheduler &operator=(const MaintenanceScheduler &) = delete;
+
+    // Run a task before the built-in ones; call before start()
+    void addTask(const std::string &name, bool writes, TaskFunction run);
+
+    // Start the background thread
+    void start();
+
+    // Postpone maintenance: called for every use of the database
+    void noteActivity();
+
+    // New work may be due (e.g. after a clear); runs once the app is idle
+    void wake();
+
+    void setOptions(const Options &options);
+    std::vector<TaskStatus> status() const;
+
+    // Run every task to completion on the calling thread, idle or not
+    bool runNow();
+
+private:
+    struct Task {
+        std::string name;
+        bool writes;
+        TaskFunction run;
+        std::chrono::steady_clock::time_point notBefore; // Set from Slice::retryIn
+        TaskStatus status;
+    };
+
+    void schedulerLoop();
+
+    // Give each due task one slice; returns true if any task has more to do
+    bool runRound(bool force, std::chrono::steady_clock::time_point &nextRetry);
+
+    Slice vacuumSlice(sqlite3 *db, std::chrono::steady_clock::time_point deadline);
+    Slice checkpointSlice(sqlite3 *db);
+    Slice optimizeSlice(sqlite3 *db);
+
+    ConnectionPool &pool;
+    std::recursive_mutex &writeMutex;
+
+    mutable std::mutex mutex; // Guards everything below except lastActivity and active
+    Options options;
+    std::vector<Task> tasks;
+    size_t builtInTasks = 0;
+    bool woken = true; // Check every task once at startup
+    bool stopping = false;
+    std::condition_variable changed;
+    std::mutex roundMutex; // One round at a time, from the thread or runNow()
+
+    std::atomic<int64_t> lastActivity{0}; // steady_clock ticks
+    std::atomic<bool> active{false};      // Activity since the last round
+    std::thread worker;
+};
+
+#endif // MAINTENANCESCHEDULER_H
@@ -0,0 +1,522 @@
+#include "MealDbClient.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include <curl/curl.h>
+
+namespace {
+
+// Append received data to a std::string
+size_t writeCallback(void *contents, size_t size, size_t nmemb, void *userp) {
+    static_cast<std::string *>(userp)->append(static_cast<char *>(contents), size * nmemb);
+    return size * nmemb;
+}
+
+// Append a received header line to a std::string
+size_t headerCallback(char *buffer, size_t size, size_t nitems, void *userp) {
+    static_cast<std::string *>(userp)->append(buffer, size * nitems);
+    return size * nitems;
+}
+
+// Value of a response header (case-insensitive name), without the line end
+std::string headerValue(const std::string &headers, const std::string &name) {
+    size_t lineStart = 0;
+    while (lineStart < headers.size()) {
+        size_t lineEnd = headers.find('\n', lineStart);
+        if (lineEnd == std::string::npos) {
+            lineEnd = headers.size();
+        }
+        std::string line = headers.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+        if (line.size() <= name.size() || line[name.size()] != ':' ||
+            !std::equal(name.begin(), name.end(), line.begin(), [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); })) {
+            continue;
+        }
+        size_t valueStart = line.find_first_not_of(' ', name.size() + 1);
+        size_t valueEnd = line.find_last_not_of(" \r");
+        return (valueStart == std::string::npos || valueEnd < valueStart) ? std::string() : line.substr(valueStart, valueEnd - valueStart + 1);
+    }
+    return std::string();
+}
+
+// libcurl's global init is not thread-safe, so run it once
+void ensureCurlInitialized() {
+    static std::once_flag curlInitFlag;
+    std::call_once(curlInitFlag, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+}
+
+// Build an endpoint URL; MEALDB_API_URL points the app at another server
+// (e.g. a local stand-in) instead of TheMealDB
+std::string apiUrl(const std::string &endpoint) {
+    // Never destroyed: request threads may still be running while the
+    // process exits
+    static const std::string *baseUrl = [] {
+        const char *override = std::getenv("MEALDB_API_URL");
+        std::string url = (override && *override) ? override : "https://www.themealdb.com/api/json/v1/1";
+        while (!url.empty() && url.back() == '/') {
+            url.pop_back();
+        }
+        return new std::string(url);
+    }();
+    return *baseUrl + "/" + endpoint;
+}
+
+// Latencies kept for the p95, and how many are needed before it is used
+const size_t kLatencySamples = 64;
+const size_t kMinLatencySamples = 16;
+
+} // namespace
+
+MealDbClient::MealDbClient(const Options &options)
+    : options(options), tokens(options.burst), refilledAt(std::chrono::steady_clock::now()) {}
+
+MealDbClient::~MealDbClient() {
+    std::vector<Pending> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        for (const std::string &endpoint : queue) {
+            auto found = inFlight.find(endpoint);
+            abandoned.push_back(std::move(found->second));
+            inFlight.erase(found);
+        }
+        queue.clear();
+    }
+    workReady.notify_all();
+    stopped.notify_all();
+    for (Pending &pending : abandoned) {
+        pending.promise.set_value(nullptr);
+        for (const Callback &callback : pending.callbacks) {
+            callback(nullptr);
+        }
+    }
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+std::shared_future<MealDbClient::Response> MealDbClient::request(const std::string &endpoint) {
+    return start(endpoint, nullptr, false);
+}
+
+void MealDbClient::request(const std::string &endpoint, Callback onDone, bool reuseFresh) {
+    start(endpoint, std::move(onDone), reuseFresh);
+}
+
+// Join the request in flight for an endpoint, answer it from memory if
+// reuseFresh allows, or queue it for the pool; onDone may be empty
+std::shared_future<MealDbClient::Response> MealDbClient::start(const std::string &endpoint, Callback onDone, bool reuseFresh) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto found = inFlight.find(endpoint);
+    if (found != inFlight.end()) {
+        ++counters.joined;
+        if (onDone) {
+            found->second.callbacks.push_back(std::move(onDone));
+        }
+        return found->second.response;
+    }
+
+    Response recent = reuseFresh ? fresh(endpoint) : nullptr;
+    if (recent || stopping) {
+        counters.cached += recent ? 1 : 0;
+        lock.unlock();
+        std::promise<Response> answered;
+        answered.set_value(recent);
+        if (onDone) {
+            onDone(recent);
+        }
+        return answered.get_future().share();
+    }
+
+    Pending &pending = inFlight[endpoint];
+    pending.response = pending.promise.get_future().share();
+    if (onDone) {
+        pending.callbacks.push_back(std::move(onDone));
+    }
+    std::shared_future<Response> response = pending.response;
+    ++counters.requests;
+
+    queue.push_back(endpoint);
+    if (queue.size() > idleWorkers && workers.size() < std::max<size_t>(options.workers, 1)) {
+        workers.emplace_back([this] { work(); });
+    } else {
+        workReady.notify_one();
+    }
+    return response;
+}
+
+void MealDbClient::work() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        ++idleWorkers;
+        workReady.wait(lock, [this] { return stopping || !queue.empty(); });
+        --idleWorkers;
+        if (stopping) {
+            return;
+        }
+        std::string endpoint = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+
+        Response result = perform(endpoint);
+        lock.lock();
+        // Later callers start a fresh request instead of reusing this one
+        auto done = inFlight.find(endpoint);
+        Pending finished = std::move(done->second);
+        inFlight.erase(done);
+        lock.unlock();
+        finished.promise.set_value(result);
+        for (const Callback &callback : finished.callbacks) {
+            callback(result);
+        }
+        lock.lock();
+    }
+}
+
+MealDbClient::Response MealDbClient::get(const std::string &endpoint) {
+    return request(endpoint).get();
+}
+
+std::string MealDbClient::encode(const std::string &value) {
+    std::string encoded;
+    char *escaped = curl_easy_escape(nullptr, value.c_str(), static_cast<int>(value.size()));
+    if (escaped) {
+        encoded = escaped;
+        curl_free(escaped);
+    }
+    return encoded;
+}
+
+bool MealDbClient::healthy() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters.breaker == Breaker::Closed;
+}
+
+void MealDbClient::setOptions(const Options &newOptions) {
+    std::lock_guard<std::mutex> lock(mutex);
+    options = newOptions;
+    tokens = std::min(tokens, options.burst);
+    while (staleLru.size() > options.staleEntries) {
+        staleIndex.erase(staleLru.back().endpoint);
+        staleLru.pop_back();
+    }
+}
+
+MealDbClient::Stats MealDbClient::stats() const {
+    std::chrono::milliseconds p95 = hedgeDelay();
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats current = counters;
+    current.p95 = p95;
+    return current;
+}
+
+// Sleep until a reserved token may be used, or until the client is destroyed
+bool MealDbClient::pause(std::chrono::steady_clock::duration wait) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return !stopped.wait_for(lock, wait, [this] { return stopping.load(); });
+}
+
+// Add the tokens earned since the last refill; called with the mutex held
+void MealDbClient::refill(std::chrono::steady_clock::time_point now) {
+    double elapsed = std::chrono::duration<double>(now - refilledAt).count();
+    tokens = std::min(options.burst, tokens + elapsed * options.requestsPerSecond);
+    refilledAt = now;
+}
+
+// Take a token from the bucket and return how long to wait before using
+// it. The balance may go negative: each request waits for its own place in
+// the queue, so requests leave in the order they asked.
+std::chrono::steady_clock::duration MealDbClient::reserveToken() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (options.requestsPerSecond <= 0) {
+        return std::chrono::steady_clock::duration::zero();
+    }
+    refill(std::chrono::steady_clock::now());
+    tokens -= 1;
+    if (tokens >= 0) {
+        return std::chrono::steady_clock::duration::zero();
+    }
+    auto wait = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(-tokens / options.requestsPerSecond));
+    counters.throttled += std::chrono::duration_cast<std::chrono::microseconds>(wait);
+    return wait;
+}
+
+// Take a token only if one is free; hedges are skipped rather than queued
+bool MealDbClient::takeTokenNow() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (options.requestsPerSecond <= 0) {
+        return true;
+    }
+    refill(std::chrono::steady_clock::now());
+    if (tokens < 1) {
+        return false;
+    }
+    tokens -= 1;
+    return true;
+}
+
+// Circuit breaker: may a request go out now? Once the cooldown is over a
+// single probe is let through; the others keep failing fast until it ends.
+MealDbClient::Admission MealDbClient::admit() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (counters.breaker == Breaker::Open &&
+        std::chrono::steady_clock::now() - openedAt >= options.breakerCooldown) {
+        counters.breaker = Breaker::HalfOpen;
+    }
+    if (counters.breaker == Breaker::Closed) {
+        return Admission::Admitted;
+    }
+    if (counters.breaker == Breaker::HalfOpen && !probeInFlight) {
+        probeInFlight = true;
+        return Admission::Probe;
+    }
+    ++counters.rejected;
+    return Admission::Rejected;
+}
+
+// Count a finished transfer. A request admitted before the breaker opened
+// may still finish while it is open or probing; only the probe's own
+// outcome closes it again or lets the next probe out.
+void MealDbClient::recordOutcome(bool ok, std::chrono::steady_clock::duration latency, bool probe) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (probe) {
+        probeInFlight = false;
+    } else if (counters.breaker != Breaker::Closed) {
+        counters.failures += ok ? 0 : 1;
+        return;
+    }
+    if (ok) {
+        consecutiveFailures = 0;
+        counters.breaker = Breaker::Closed;
+        latencies.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(latency));
+        if (latencies.size() > kLatencySamples) {
+            latencies.pop_front();
+        }
+        return;
+    }
+    ++counters.failures;
+    ++consecutiveFailures;
+    if (counters.breaker == Breaker::HalfOpen || consecutiveFailures >= options.failureThreshold) {
+        counters.breaker = Breaker::Open;
+        openedAt = std::chrono::steady_clock::now();
+    }
+}
+
+// How long a transfer may run before it is hedged: the p95 of recent
+// successful latencies, or the configured delay until there are enough
+std::chrono::milliseconds MealDbClient::hedgeDelay() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (latencies.size() < kMinLatencySamples) {
+        return options.initialHedgeDelay;
+    }
+    std::vector<std::chrono::milliseconds> sorted(latencies.begin(), latencies.end());
+    auto p95 = sorted.begin() + (sorted.size() * 95) / 100;
+    std::nth_element(sorted.begin(), p95, sorted.end());
+    return std::max(*p95, std::chrono::milliseconds(1));
+}
+
+// One request on the calling thread: breaker, rate limit, then the transfer.
+// Falls back to the last good response when the API doesn't answer.
+MealDbClient::Response MealDbClient::perform(const std::string &endpoint) {
+    Admission admission = admit();
+    if (admission == Admission::Rejected) {
+        return stale(endpoint);
+    }
+    if (!pause(reserveToken())) {
+        return nullptr;
+    }
+    Response response = transfer(endpoint, std::string(), std::string(), admission == Admission::Probe).body;
+    if (response) {
+        remember(endpoint, response);
+        return response;
+    }
+    return stale(endpoint);
+}
+
+MealDbClient::Fetched MealDbClient::fetch(const std::string &endpoint, const std::string &etag, const std::string &lastModified) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++counters.requests;
+    }
+    Admission admission = admit();
+    if (admission == Admission::Rejected || !pause(reserveToken())) {
+        return Fetched();
+    }
+    Fetched fetched = transfer(endpoint, etag, lastModified, admission == Admission::Probe);
+    if (fetched.status == FetchStatus::Fresh) {
+        remember(endpoint, fetched.body);
+    }
+    return fetched;
+}
+
+// GET with a deadline, hedged once the first copy is slower than usual. With
+// validators it is a conditional GET and a 304 counts as success.
+MealDbClient::Fetched MealDbClient::transfer(const std::string &endpoint, const std::string &etag, const std::string &lastModified, bool probe) {
+    std::chrono::milliseconds timeout, connectTimeout;
+    bool hedge;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        timeout = options.timeout;
+        connectTimeout = options.connectTimeout;
+        hedge = options.hedge;
+    }
+    auto started = std::chrono::steady_clock::now();
+    auto deadline = started + timeout;
+    auto hedgeAt = started + hedgeDelay();
+
+    Fetched fetched;
+    ensureCurlInitialized();
+    CURLM *multi = curl_multi_init();
+    if (!multi) {
+        recordOutcome(false, {}, probe);
+        return fetched;
+    }
+    std::string url = apiUrl(endpoint);
+    struct curl_slist *validators = nullptr;
+    if (!etag.empty()) {
+        validators = curl_slist_append(validators, ("If-None-Match: " + etag).c_str());
+    }
+    if (!lastModified.empty()) {
+        validators = curl_slist_append(validators, ("If-Modified-Since: " + lastModified).c_str());
+    }
+    std::string bodies[2];
+    std::string headers[2];
+    long statuses[2] = {0, 0};
+    CURL *handles[2] = {nullptr, nullptr};
+    std::chrono::steady_clock::time_point startedAt[2];
+    auto launch = [&](int copy) {
+        CURL *curl = curl_easy_init();
+        if (!curl) {
+            return false;
+        }
+        startedAt[copy] = std::chrono::steady_clock::now();
+        long remaining = std::max(1L, static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - startedAt[copy]).count()));
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &bodies[copy]);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, headerCallback);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &headers[copy]);
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, validators);
+        curl_easy_setopt(curl, CURLOPT_PRIVATE, reinterpret_cast<char *>(static_cast<intptr_t>(copy)));
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L); // Timeouts must not raise signals on a worker thread
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, remaining);
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, std::min(remaining, static_cast<long>(connectTimeout.count())));
+        curl_multi_add_handle(multi, curl);
+        handles[copy] = curl;
+        return true;
+    };
+
+    int winner = -1;
+    if (launch(0)) {
+        int running = 1;
+        while (true) {
+            curl_multi_perform(multi, &running);
+            int queued;
+            while (CURLMsg *message = curl_multi_info_read(multi, &queued)) {
+                if (message->msg != CURLMSG_DONE) {
+                    continue;
+                }
+                char *copy = nullptr;
+                long status = 0;
+                curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &copy);
+                curl_easy_getinfo(message->easy_handle, CURLINFO_RESPONSE_CODE, &status);
+                bool answered = status == 200 || (status == 304 && validators);
+                if (message->data.result == CURLE_OK && answered && winner < 0) {
+                    winner = static_cast<int>(reinterpret_cast<intptr_t>(copy));
+                    statuses[winner] = status;
+                }
+            }
+            // A copy that failed outright is not hedged; the breaker counts it
+            auto now = std::chrono::steady_clock::now();
+            if (winner >= 0 || running == 0 || now >= deadline || stopping) {
+                break;
+            }
+            if (hedge && !handles[1] && now >= hedgeAt) {
+                if (takeTokenNow() && launch(1)) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ++counters.hedges;
+                }
+                hedge = false;
+                continue;
+            }
+            auto wake = (hedge && !handles[1]) ? std::min(deadline, hedgeAt) : deadline;
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(wake - now).count();
+            curl_multi_poll(multi, nullptr, 0, static_cast<int>(std::max<int64_t>(1, std::min<int64_t>(wait, 100))), nullptr);
+        }
+    }
+
+    if (winner >= 0 && statuses[winner] == 304) {
+        fetched.status = FetchStatus::NotModified;
+    } else if (winner >= 0) {
+        // Read lazily by MealJsonReader; an error page from a proxy is not JSON
+        size_t start = bodies[winner].find_first_not_of(" \t\r\n");
+        if (start != std::string::npos && bodies[winner][start] == '{') {
+            fetched.status = FetchStatus::Fresh;
+            fetched.body = std::make_shared<const std::string>(std::move(bodies[winner]));
+        }
+    }
+    if (fetched.status != FetchStatus::Failed) {
+        fetched.etag = headerValue(headers[winner], "ETag");
+        fetched.lastModified = headerValue(headers[winner], "Last-Modified");
+    }
+    auto latency = winner >= 0 ? std::chrono::steady_clock::now() - startedAt[winner] : std::chrono::steady_clock::duration::zero();
+    for (CURL *curl : handles) {
+        if (curl) {
+            curl_multi_remove_handle(multi, curl);
+            curl_easy_cleanup(curl);
+        }
+    }
+    curl_multi_cleanup(multi);
+    curl_slist_free_all(validators);
+
+    bool ok = fetched.status != FetchStatus::Failed;
+    if (ok && winner == 1) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++counters.hedgeWins;
+    }
+    recordOutcome(ok, latency, probe);
+    return fetched;
+}
+
+// Keep the last good response for an endpoint, for repeats and for when
+// the API is down
+void MealDbClient::remember(const std::string &endpoint, const Response &response) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (options.staleEntries == 0) {
+        return;
+    }
+    auto found = staleIndex.find(endpoint);
+    if (found != staleIndex.end()) {
+        staleLru.erase(found->second);
+    }
+    staleLru.push_front(Remembered{endpoint, response, std::chrono::steady_clock::now()});
+    staleIndex[endpoint] = staleLru.begin();
+    while (staleLru.size() > options.staleEntries) {
+        staleIndex.erase(staleLru.back().endpoint);
+        staleLru.pop_back();
+    }
+}
+
+MealDbClient::Response MealDbClient::stale(const std::string &endpoint) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = staleIndex.find(endpoint);
+    if (found == staleIndex.end()) {
+        return nullptr;
+    }
+    ++counters.staleServed;
+    return found->second->response;
+}
+
+// The remembered response if it is younger than Options::freshFor; a hit
+// moves to the front, so entries in use aren't dropped first
+MealDbClient::Response MealDbClient::fresh(const std::string &endpoint) {
+    auto found = staleIndex.find(endpoint);
+    if (found == staleIndex.end() || std::chrono::steady_clock::now() - found->second->storedAt >= options.freshFor) {
+        return nullptr;
+    }
+    staleLru.splice(staleLru.begin(), staleLru, found->second);
+    return found->second->response;
+}
@@ -0,0 +1,167 @@
+#ifndef MEALDBCLIENT_H
+#define MEALDBCLIENT_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// HTTP access to TheMealDB for every caller in the process.
+// Concurrent requests for the same endpoint share one HTTP call and its
+// response body (single-flight). A request that asks for it is answered
+// from memory while the last response is younger than Options::freshFor;
+// every other request goes out. Requests leave through a token bucket: up
+// to Options::burst at once, then Options::requestsPerSecond, so a burst of
+// views or threads doesn't get the app throttled.
+//
+// Tail latency: every transfer has a deadline, and one that is still
+// running after the p95 of recent latencies gets a second copy (a hedge);
+// whichever answers first wins. After Options::failureThreshold failures in
+// a row the circuit breaker opens and requests fail fast for
+// Options::breakerCooldown, then a single probe decides whether it closes.
+// While the API is failing, the last good response for an endpoint is
+// returned instead, if there is one.
+//
+// Requests run on a pool of at most Options::workers threads, started as
+// they are needed; the rest wait in a queue. Destroying the client fails
+// the queued requests, cuts short the ones running and joins the pool.
+class MealDbClient {
+public:
+    struct Options {
+        size_t workers = 8;                              // Most request threads; started ones stay until destruction
+        double requestsPerSecond = 5.0;                  // Sustained rate; 0 = unlimited
+        double burst = 10.0;                             // Requests allowed at once after a quiet spell
+        std::chrono::milliseconds timeout{10000};        // Whole request, hedge included
+        std::chrono::milliseconds connectTimeout{3000};
+        bool hedge = true;
+        std::chrono::milliseconds initialHedgeDelay{1000}; // Until enough latencies are known
+        int failureThreshold = 5;                        // Failures in a row that open the breaker
+        std::chrono::milliseconds breakerCooldown{30000};
+        size_t staleEntries = 256;                       // Last good responses kept, for repeats and outages
+        std::chrono::milliseconds freshFor{300000};      // Age of responses reused by reuseFresh requests; 0 = never
+    };
+
+    // Response body, a JSON object; nullptr if the request failed. Read it
+    // with MealJsonReader.
+    using Response = std::shared_ptr<const std::string>;
+    using Callback = std::function<void(const Response &response)>;
+
+    enum class Breaker { Closed, Open, HalfOpen };
+
+    struct Stats {
+        size_t requests = 0;  // Requests made, not counting hedges
+        size_t joined = 0;    // Requests that shared one already in flight
+        size_t cached = 0;    // Requests answered by a response younger than freshFor
+        size_t hedges = 0;    // Second copies sent
+        size_t hedgeWins = 0; // Second copies that answered first
+        size_t failures = 0;  // Requests that got no usable response
+        size_t rejected = 0;  // Failed fast because the breaker was open
+        size_t staleServed = 0;
+        std::chrono::microseconds throttled{0}; // Total time requests waited for a token
+        std::chrono::milliseconds p95{0};       // Current hedge delay
+        Breaker breaker = Breaker::Closed;
+    };
+
+    explicit MealDbClient(const Options &options);
+    ~MealDbClient();
+
+    MealDbClient(const MealDbClient &) = delete;
+    MealDbClient &operator=(const MealDbClient &) = delete;
+
+    // Start the request for an endpoint such as "filter.php?i=chicken", or
+    // join the one in flight
+    std::shared_future<Response> request(const std::string &endpoint);
+    Response get(const std::string &endpoint); // request() and wait
+
+    // The same, but onDone is called with the response instead of waiting
+    // on a future: on a pool thread, or on this one if the response is
+    // already known. Keep it short and don't wait on other requests in it;
+    // the thread is shared. With
+    // reuseFresh, a response younger than Options::freshFor is reused
+    // instead of asking again, for lists that change rarely.
+    void request(const std::string &endpoint, Callback onDone, bool reuseFresh = false);
+
+    // Conditional GET for refreshes, outside single-flight and without the
+    // stale fallback. Pass the validators from the last Fresh result; an
+    // unchanged endpoint comes back NotModified without a body.
+    enum class FetchStatus { Fresh, NotModified, Failed };
+    struct Fetched {
+        FetchStatus status = FetchStatus::Failed;
+        Response body;
+        std::string etag;
+        std::string lastModified;
+    };
+    Fetched fetch(const std::string &endpoint, const std::string &etag, const std::string &lastModified);
+
+    // Percent-encode a query string value
+    static std::string encode(const std::string &value);
+
+    bool healthy() const; // The breaker is closed
+    void setOptions(const Options &options);
+    Stats stats() const;
+
+private:
+    void work(); // Pool thread: run queued requests until the client is destroyed
+    bool pause(std::chrono::steady_clock::duration wait); // false if the client is being destroyed
+    std::chrono::steady_clock::duration reserveToken();
+    bool takeTokenNow();
+    void refill(std::chrono::steady_clock::time_point now);
+    enum class Admission { Rejected, Admitted, Probe };
+    Admission admit();
+    void recordOutcome(bool ok, std::chrono::steady_clock::duration latency, bool probe);
+    std::chrono::milliseconds hedgeDelay() const;
+    std::shared_future<Response> start(const std::string &endpoint, Callback onDone, bool reuseFresh);
+    Response perform(const std::string &endpoint);
+    Fetched transfer(const std::string &endpoint, const std::string &etag, const std::string &lastModified, bool probe);
+    void remember(const std::string &endpoint, const Response &response);
+    Response stale(const std::string &endpoint);
+    Response fresh(const std::string &endpoint); // Called with the mutex held
+
+    mutable std::mutex mutex;
+    Options options;
+    struct Pending {
+        std::promise<Response> promise;
+        std::shared_future<Response> response;
+        std::vector<Callback> callbacks; // Called once the response is set
+    };
+    std::unordered_map<std::string, Pending> inFlight;
+    Stats counters;
+
+    // Request threads and the endpoints waiting for one
+    std::vector<std::thread> workers;
+    std::deque<std::string> queue;
+    size_t idleWorkers = 0;
+    std::condition_variable workReady;
+    std::condition_variable stopped; // Wakes requests waiting for a token
+    std::atomic<bool> stopping{false};
+
+    // Token bucket
+    double tokens;
+    std::chrono::steady_clock::time_point refilledAt;
+
+    // Hedging and circuit breaker
+    std::deque<std::chrono::milliseconds> latencies; // Most recent successes
+    int consecutiveFailures = 0;
+    std::chrono::steady_clock::time_point openedAt;
+    bool probeInFlight = false;
+
+    // Last good responses, most recently stored first
+    struct Remembered {
+        std::string endpoint;
+        Response response;
+        std::chrono::steady_clock::time_point storedAt;
+    };
+    std::list<Remembered> staleLru;
+    std::unordered_map<std::string, std::list<Remembered>::iterator> staleIndex;
+};
+
+#endif // MEALDBCLIENT_H
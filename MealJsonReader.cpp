@@ -0,0 +1,271 @@
+#include "MealJsonReader.h"
+#include <cstring>
+
+MealJsonReader::MealJsonReader(std::string_view body, const std::vector<std::string> &fields)
+    : pos(body.data()), end(body.data() + body.size()), wanted(fields), values(fields.size()) {
+    // Find "meals" among the top-level keys and stop inside its array
+    skipSpace();
+    if (pos == end || *pos != '{') {
+        fail();
+        return;
+    }
+    ++pos;
+    while (true) {
+        skipSpace();
+        if (pos != end && *pos == '}') {
+            return; // No meals
+        }
+        std::string_view key;
+        if (!readKey(key)) {
+            return;
+        }
+        skipSpace();
+        if (key == "meals" && pos != end && *pos == '[') {
+            ++pos;
+            inMeals = true;
+            return;
+        }
+        if (!skipValue()) {
+            return;
+        }
+        skipSpace();
+        if (pos != end && *pos == ',') {
+            ++pos;
+        }
+    }
+}
+
+bool MealJsonReader::fail() {
+    good = false;
+    inMeals = false;
+    return false;
+}
+
+void MealJsonReader::skipSpace() {
+    while (pos != end && (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t')) {
+        ++pos;
+    }
+}
+
+// Past the closing quote of the string starting at pos
+bool MealJsonReader::skipString() {
+    for (++pos; pos < end; ++pos) {
+        if (*pos == '\\') {
+            ++pos;
+        } else if (*pos == '"') {
+            ++pos;
+            return true;
+        }
+    }
+    return fail();
+}
+
+// Past one value of any kind; containers are skipped by bracket depth
+bool MealJsonReader::skipValue() {
+    if (pos == end) {
+        return fail();
+    }
+    if (*pos == '"') {
+        return skipString();
+    }
+    if (*pos == '{' || *pos == '[') {
+        int depth = 0;
+        while (pos < end) {
+            char c = *pos;
+            if (c == '"') {
+                if (!skipString()) {
+                    return false;
+                }
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                ++depth;
+            } else if ((c == '}' || c == ']') && --depth == 0) {
+                ++pos;
+                return true;
+            }
+            ++pos;
+        }
+        return fail();
+    }
+    const char *start = pos;
+    while (pos != end && !std::strchr(",}] \n\r\t", *pos)) {
+        ++pos;
+    }
+    return pos != start || fail();
+}
+
+// A quoted key and its colon; keys are compared as written, unescaped
+bool MealJsonReader::readKey(std::string_view &key) {
+    skipSpace();
+    if (pos == end || *pos != '"') {
+        return fail();
+    }
+    const char *start = pos + 1;
+    if (!skipString()) {
+        return false;
+    }
+    key = std::string_view(start, pos - 1 - start);
+    skipSpace();
+    if (pos == end || *pos != ':') {
+        return fail();
+    }
+    ++pos;
+    return true;
+}
+
+bool MealJsonReader::nextMeal() {
+    while (inMeals) {
+        skipSpace();
+        if (pos == end) {
+            return fail();
+        }
+        if (*pos == ']') {
+            inMeals = false;
+            return false;
+        }
+        if (!firstMeal) {
+            if (*pos != ',') {
+                return fail();
+            }
+            ++pos;
+            skipSpace();
+        }
+        firstMeal = false;
+        if (pos == end) {
+            return fail();
+        }
+        if (*pos != '{') {
+            if (!skipValue()) {
+                return false;
+            }
+            continue; // Not a meal
+        }
+
+        ++pos;
+        for (std::string_view &value : values) {
+            value = std::string_view();
+        }
+        skipSpace();
+        if (pos != end && *pos == '}') {
+            ++pos;
+            return true;
+        }
+        while (true) {
+            std::string_view key;
+            if (!readKey(key)) {
+                return false;
+            }
+            skipSpace();
+            size_t field = wanted.size();
+            if (pos != end && *pos == '"') {
+                for (size_t i = 0; i < wanted.size(); ++i) {
+                    if (key == wanted[i]) {
+                        field = i;
+                        break;
+                    }
+                }
+            }
+            const char *start = pos + 1;
+            if (!skipValue()) {
+                return false;
+            }
+            if (field < wanted.size()) {
+                values[field] = std::string_view(start, pos - 1 - start);
+            }
+            skipSpace();
+            if (pos == end) {
+                return fail();
+            }
+            if (*pos == '}') {
+                ++pos;
+                return true;
+            }
+            if (*pos != ',') {
+                return fail();
+            }
+            ++pos;
+        }
+    }
+    return false;
+}
+
+bool MealJsonReader::has(size_t field) const {
+    return field < values.size() && values[field].data() != nullptr;
+}
+
+// Decode the escapes of a field; most values have none and are copied as is
+std::string MealJsonReader::field(size_t field) const {
+    if (!has(field)) {
+        return std::string();
+    }
+    std::string_view raw = values[field];
+    if (raw.find('\\') == std::string_view::npos) {
+        return std::string(raw);
+    }
+
+    auto hex = [&](size_t at, unsigned &code) {
+        if (at + 4 > raw.size()) {
+            return false;
+        }
+        code = 0;
+        for (size_t i = at; i < at + 4; ++i) {
+            char c = raw[i];
+            int digit = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+            if (digit < 0) {
+                return false;
+            }
+            code = code * 16 + static_cast<unsigned>(digit);
+        }
+        return true;
+    };
+
+    std::string decoded;
+    decoded.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); ++i) {
+        if (raw[i] != '\\' || i + 1 == raw.size()) {
+            decoded += raw[i];
+            continue;
+        }
+        char escape = raw[++i];
+        switch (escape) {
+        case 'b': decoded += '\b'; break;
+        case 'f': decoded += '\f'; break;
+        case 'n': decoded += '\n'; break;
+        case 'r': decoded += '\r'; break;
+        case 't': decoded += '\t'; break;
+        case 'u': {
+            unsigned code;
+            if (!hex(i + 1, code)) {
+                decoded += '?';
+                break;
+            }
+            i += 4;
+            unsigned low;
+            if (code >= 0xD800 && code < 0xDC00 && i + 2 < raw.size() && raw[i + 1] == '\\' && raw[i + 2] == 'u' &&
+                hex(i + 3, low) && low >= 0xDC00 && low < 0xE000) {
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                i += 6;
+            }
+            if (code < 0x80) {
+                decoded += static_cast<char>(code);
+            } else if (code < 0x800) {
+                decoded += static_cast<char>(0xC0 | (code >> 6));
+                decoded += static_cast<char>(0x80 | (code & 0x3F));
+            } else if (code < 0x10000) {
+                decoded += static_cast<char>(0xE0 | (code >> 12));
+                decoded += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                decoded += static_cast<char>(0x80 | (code & 0x3F));
+            } else {
+                decoded += static_cast<char>(0xF0 | (code >> 18));
+                decoded += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                decoded += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                decoded += static_cast<char>(0x80 | (code & 0x3F));
+            }
+            break;
+        }
+        default: decoded += escape; break; // \" \\ \/
+        }
+    }
+    return decoded;
+}
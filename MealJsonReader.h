@@ -0,0 +1,42 @@
+#ifndef MEALJSONREADER_H
+#define MEALJSONREADER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Pull reader for TheMealDB responses: {"meals": [{...}, ...]} or
+// {"meals": null}. It walks the text once without building a DOM. For each
+// meal it notes where the wanted fields are and skips every other value in
+// place, nested objects and arrays included. Nothing is allocated until a
+// field is read, and only that string is decoded. The text is checked only
+// as far as it is walked; a malformed body ends the meals early and clears
+// ok().
+class MealJsonReader {
+public:
+    // fields: the string fields callers will read, by index, e.g. "strMeal".
+    // The body and the field list must outlive the reader.
+    MealJsonReader(std::string_view body, const std::vector<std::string> &fields);
+
+    bool nextMeal(); // Move to the next meal; false at the end
+    bool has(size_t field) const; // The current meal has this field as a string
+    std::string field(size_t field) const; // Decoded value; empty if !has(field)
+    bool ok() const { return good; }
+
+private:
+    void skipSpace();
+    bool skipString();
+    bool skipValue();
+    bool readKey(std::string_view &key);
+    bool fail();
+
+    const char *pos;
+    const char *end;
+    const std::vector<std::string> &wanted;
+    std::vector<std::string_view> values; // Raw text between the quotes per wanted field; null data if absent
+    bool good = true;
+    bool inMeals = false;
+    bool firstMeal = true;
+};
+
+#endif // MEALJSONREADER_H
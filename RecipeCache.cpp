@@ -0,0 +1,220 @@
+#include "RecipeCache.h"
+#include "RecipeManager.h"
+#include <cstring>
+
+namespace {
+
+// Past this many rows a transaction invalidates the whole cache instead
+const size_t kMaxTrackedRows = 1024;
+
+// Same threshold as SQLite's automatic checkpoint
+const int kCheckpointPages = 1000;
+
+} // namespace
+
+RecipeCache::RecipeCache(size_t capacity, size_t shardCount) {
+    for (size_t i = 0; i < (shardCount ? shardCount : 1); ++i) {
+        shards.push_back(std::unique_ptr<Shard>(new Shard()));
+    }
+    setCapacity(capacity);
+}
+
+RecipeCache::~RecipeCache() = default;
+
+RecipeCache::Shard &RecipeCache::shardFor(int64_t id) const {
+    return *shards[static_cast<uint64_t>(id) % shards.size()];
+}
+
+RecipeCache::Entry RecipeCache::get(int64_t id) {
+    Shard &shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.index.find(id);
+    if (found == shard.index.end()) {
+        ++shard.misses;
+        return nullptr;
+    }
+    ++shard.hits;
+    shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+    return found->second->second;
+}
+
+uint64_t RecipeCache::token(int64_t id) const {
+    Shard &shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.epoch;
+}
+
+void RecipeCache::put(int64_t id, Entry recipe, uint64_t token) {
+    Shard &shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.capacity == 0 || uncached || shard.epoch != token || writingAll > 0 || shard.writing.count(id)) {
+        return; // Written since the reader took its token, or still being written
+    }
+    auto found = shard.index.find(id);
+    if (found != shard.index.end()) {
+        found->second->second = std::move(recipe);
+        shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+        return;
+    }
+    shard.lru.emplace_front(id, std::move(recipe));
+    shard.index[id] = shard.lru.begin();
+    trim(shard);
+}
+
+// Drop least recently used entries until the shard fits its capacity
+void RecipeCache::trim(Shard &shard) {
+    while (shard.lru.size() > shard.capacity) {
+        shard.index.erase(shard.lru.back().first);
+        shard.lru.pop_back();
+        ++shard.evictions;
+    }
+}
+
+void RecipeCache::invalidate(int64_t id) {
+    Shard &shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    ++shard.epoch;
+    auto found = shard.index.find(id);
+    if (found != shard.index.end()) {
+        shard.lru.erase(found->second);
+        shard.index.erase(found);
+    }
+}
+
+void RecipeCache::invalidateAll() {
+    for (auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        ++shard->epoch;
+        shard->lru.clear();
+        shard->index.clear();
+    }
+}
+
+void RecipeCache::setCapacity(size_t capacity) {
+    size_t perShard = (capacity + shards.size() - 1) / shards.size();
+    for (auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->capacity = perShard;
+        trim(*shard);
+    }
+}
+
+RecipeCache::Stats RecipeCache::stats() const {
+    Stats total;
+    for (const auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total.entries += shard->lru.size();
+        total.hits += shard->hits;
+        total.misses += shard->misses;
+        total.evictions += shard->evictions;
+    }
+    return total;
+}
+
+void RecipeCache::attach(sqlite3 *db) {
+    // Rows are released when the WAL hook reports a commit. Without WAL (an
+    // in-memory database, or a file that refused the mode) there is no such
+    // point, so nothing is cached from then on.
+    bool wal = false;
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "PRAGMA journal_mode;", -1, &stmt, nullptr) == SQLITE_OK) {
+        wal = sqlite3_step(stmt) == SQLITE_ROW &&
+              sqlite3_stricmp(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)), "wal") == 0;
+        sqlite3_finalize(stmt);
+    }
+    if (!wal) {
+        uncached = true;
+        invalidateAll();
+        return;
+    }
+
+    Connection *connection = new Connection{this, {}, false};
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        connections.push_back(std::unique_ptr<Connection>(connection));
+    }
+    sqlite3_update_hook(db, onUpdate, connection);
+    sqlite3_wal_hook(db, onWalCommit, connection);
+    sqlite3_rollback_hook(db, onRollback, connection);
+}
+
+// A row is written: evict it and keep it out until the transaction ends
+void RecipeCache::beginWrite(Connection &connection, int64_t id) {
+    if (connection.all || connection.rows.count(id)) {
+        return;
+    }
+    if (connection.rows.size() >= kMaxTrackedRows) {
+        beginWriteAll(connection);
+        return;
+    }
+    connection.rows.insert(id);
+    Shard &shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    ++shard.writing[id];
+    ++shard.epoch;
+    auto found = shard.index.find(id);
+    if (found != shard.index.end()) {
+        shard.lru.erase(found->second);
+        shard.index.erase(found);
+    }
+}
+
+void RecipeCache::beginWriteAll(Connection &connection) {
+    if (!connection.all) {
+        connection.all = true;
+        ++writingAll;
+        invalidateAll();
+    }
+}
+
+// The transaction committed or rolled back: evict its rows once more, since
+// readers may have cached them meanwhile from their snapshots, then let
+// them be cached again. Epochs move before the rows are released.
+void RecipeCache::endWrite(Connection &connection) {
+    if (connection.all) {
+        invalidateAll();
+        --writingAll;
+    }
+    for (int64_t id : connection.rows) {
+        Shard &shard = shardFor(id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        ++shard.epoch;
+        auto found = shard.index.find(id);
+        if (found != shard.index.end()) {
+            shard.lru.erase(found->second);
+            shard.index.erase(found);
+        }
+        auto writing = shard.writing.find(id);
+        if (writing != shard.writing.end() && --writing->second == 0) {
+            shard.writing.erase(writing);
+        }
+    }
+    connection.rows.clear();
+    connection.all = false;
+}
+
+void RecipeCache::onUpdate(void *data, int, const char *database, const char *table, sqlite3_int64 rowid) {
+    Connection &connection = *static_cast<Connection *>(data);
+    if (std::strcmp(database, "main") != 0) {
+        return;
+    }
+    if (std::strcmp(table, "recipes") == 0) {
+        connection.cache->beginWrite(connection, rowid);
+    } else if (std::strcmp(table, "recipe_meta") == 0) {
+        connection.cache->beginWriteAll(connection); // A clear or undo swaps every visible row
+    }
+}
+
+int RecipeCache::onWalCommit(void *data, sqlite3 *db, const char *database, int pages) {
+    Connection &connection = *static_cast<Connection *>(data);
+    connection.cache->endWrite(connection);
+    if (pages >= kCheckpointPages) {
+        sqlite3_wal_checkpoint(db, database);
+    }
+    return SQLITE_OK;
+}
+
+void RecipeCache::onRollback(void *data) {
+    Connection &connection = *static_cast<Connection *>(data);
+    connection.cache->endWrite(connection);
+}
@@ -0,0 +1,96 @@
+#ifndef RECIPECACHE_H
+#define RECIPECACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <sqlite3.h>
+
+struct Recipe;
+
+// Bounded LRU cache of decoded recipes, keyed by database ID.
+// The capacity is split over shards, each with its own lock, so readers of
+// different recipes rarely wait for each other. attach() hooks a connection
+// so that every write to the recipes table evicts the rows it touches, both
+// when the row changes and again when the transaction ends. A reader takes
+// token() before reading a row and passes it to put(); if the row was
+// written in between, or belongs to a transaction that is still open, the
+// put is dropped, so an old copy can't outlive the eviction. Writes made by
+// other processes are not seen.
+class RecipeCache {
+public:
+    using Entry = std::shared_ptr<const Recipe>;
+
+    struct Stats {
+        size_t entries = 0;
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0; // Dropped to make room, not invalidated
+    };
+
+    explicit RecipeCache(size_t capacity = 4096, size_t shardCount = 16);
+    ~RecipeCache();
+
+    RecipeCache(const RecipeCache &) = delete;
+    RecipeCache &operator=(const RecipeCache &) = delete;
+
+    Entry get(int64_t id); // nullptr on a miss
+    uint64_t token(int64_t id) const; // Take before reading the row
+    void put(int64_t id, Entry recipe, uint64_t token);
+
+    void invalidate(int64_t id);
+    void invalidateAll();
+    void setCapacity(size_t capacity); // 0 turns caching off
+    Stats stats() const;
+
+    // Install the update, WAL and rollback hooks; call from the connection's
+    // initializer. The WAL hook also checkpoints at 1000 pages, like the
+    // automatic checkpoint it replaces. A connection that isn't in WAL mode
+    // turns the cache off for good.
+    void attach(sqlite3 *db);
+
+private:
+    struct Shard {
+        std::mutex mutex;
+        std::list<std::pair<int64_t, Entry>> lru; // Most recently used first
+        std::unordered_map<int64_t, std::list<std::pair<int64_t, Entry>>::iterator> index;
+        std::unordered_map<int64_t, int> writing; // Rows changed by open transactions
+        uint64_t epoch = 0; // Bumped whenever a row of this shard is written
+        size_t capacity = 0;
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+    };
+
+    // Rows written by the open transaction of one connection. Only touched
+    // by the thread using that connection, from inside its hooks.
+    struct Connection {
+        RecipeCache *cache;
+        std::unordered_set<int64_t> rows;
+        bool all = false; // Too many rows to track, or the generation may have changed
+    };
+
+    Shard &shardFor(int64_t id) const;
+    void beginWrite(Connection &connection, int64_t id);
+    void beginWriteAll(Connection &connection);
+    void endWrite(Connection &connection);
+    void trim(Shard &shard);
+
+    static void onUpdate(void *data, int op, const char *database, const char *table, sqlite3_int64 rowid);
+    static int onWalCommit(void *data, sqlite3 *db, const char *database, int pages);
+    static void onRollback(void *data);
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::atomic<int> writingAll{0}; // Open transactions with Connection::all set
+    std::atomic<bool> uncached{false}; // A connection without WAL was attached
+
+    std::mutex connectionsMutex;
+    std::vector<std::unique_ptr<Connection>> connections;
+};
+
+#endif // RECIPECACHE_H
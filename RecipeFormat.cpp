@@ -0,0 +1,267 @@
+#include "RecipeFormat.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace {
+
+const char kBsonArrayKey[] = "recipes"; // Bson needs a document at the top level
+
+// Bson header: document length, array element type and key, array length
+const size_t kBsonHeaderSize = 4 + 1 + sizeof(kBsonArrayKey) + 4;
+
+void putInt32(std::string &bytes, size_t offset, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        bytes[offset + i] = static_cast<char>((value >> (8 * i)) & 0xff); // Little endian
+    }
+}
+
+// Builds each element of the outermost recipe array from SAX events and
+// hands it over as soon as it is complete
+class RecipeArraySax : public nlohmann::json_sax<nlohmann::json> {
+public:
+    RecipeArraySax(int elementDepth, const std::function<bool(nlohmann::json &&)> &onRecipe)
+        : elementDepth(elementDepth), onRecipe(onRecipe) {}
+
+    bool null() override { return add(nullptr); }
+    bool boolean(bool val) override { return add(val); }
+    bool number_integer(number_integer_t val) override { return add(val); }
+    bool number_unsigned(number_unsigned_t val) override { return add(val); }
+    bool number_float(number_float_t val, const string_t &) override { return add(val); }
+    bool string(string_t &val) override { return add(std::move(val)); }
+    bool binary(binary_t &val) override { return add(nlohmann::json::binary(std::move(val))); }
+
+    bool start_object(std::size_t) override { return open(nlohmann::json::object()); }
+    bool start_array(std::size_t) override { return open(nlohmann::json::array()); }
+    bool end_object() override { return close(); }
+    bool end_array() override { return close(); }
+
+    bool key(string_t &val) override {
+        lastKey = std::move(val);
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &) override {
+        return false;
+    }
+
+private:
+    // Store a value in the element being built; values outside of an
+    // element (e.g. a null top level) are skipped
+    bool add(nlohmann::json &&value) {
+        if (stack.empty()) {
+            return depth != elementDepth || onRecipe(std::move(value));
+        }
+        nlohmann::json &parent = *stack.back();
+        if (parent.is_array()) {
+            parent.push_back(std::move(value));
+        } else {
+            parent[lastKey] = std::move(value);
+        }
+        return true;
+    }
+
+    bool open(nlohmann::json &&container) {
+        if (!stack.empty()) {
+            nlohmann::json &parent = *stack.back();
+            if (parent.is_array()) {
+                parent.push_back(std::move(container));
+                stack.push_back(&parent.back());
+            } else {
+                nlohmann::json &child = parent[lastKey];
+                child = std::move(container);
+                stack.push_back(&child);
+            }
+        } else if (depth == elementDepth) {
+            current = std::move(container);
+            stack.push_back(&current);
+        }
+        ++depth;
+        return true;
+    }
+
+    bool close() {
+        --depth;
+        if (stack.empty()) {
+            return true;
+        }
+        stack.pop_back();
+        return !stack.empty() || onRecipe(std::move(current));
+    }
+
+    int elementDepth;
+    const std::function<bool(nlohmann::json &&)> &onRecipe;
+    int depth = 0;
+    nlohmann::json current;
+    std::vector<nlohmann::json *> stack;
+    std::string lastKey;
+};
+
+} // namespace
+
+RecipeFormat recipeFormatForPath(const std::string &path) {
+    size_t dot = path.find_last_of('.');
+    std::string extension = (dot == std::string::npos) ? "" : path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+    if (extension == "ndjson" || extension == "jsonl") {
+        return RecipeFormat::Ndjson;
+    }
+    if (extension == "cbor") {
+        return RecipeFormat::Cbor;
+    }
+    if (extension == "msgpack" || extension == "mpk") {
+        return RecipeFormat::MessagePack;
+    }
+    if (extension == "bson") {
+        return RecipeFormat::Bson;
+    }
+    return RecipeFormat::Json;
+}
+
+RecipeWriter::RecipeWriter(std::ostream &out, RecipeFormat format) : out(out), format(format) {}
+
+void RecipeWriter::begin(size_t count) {
+    start = out.tellp();
+    switch (format) {
+    case RecipeFormat::Json:
+        break; // The opening bracket comes with the first element
+    case RecipeFormat::Ndjson:
+        break;
+    case RecipeFormat::Cbor:
+        out.put(static_cast<char>(0x9f)); // Array of indefinite length
+        break;
+    case RecipeFormat::MessagePack: {
+        uint32_t n = static_cast<uint32_t>(count);
+        char header[5] = {static_cast<char>(0xdd), static_cast<char>(n >> 24), static_cast<char>(n >> 16),
+                          static_cast<char>(n >> 8), static_cast<char>(n)};
+        out.write(header, sizeof(header)); // array 32
+        break;
+    }
+    case RecipeFormat::Bson: {
+        std::string header(kBsonHeaderSize, '\0'); // Lengths are patched in finish()
+        header[4] = 0x04; // Array element
+        std::copy(kBsonArrayKey, kBsonArrayKey + sizeof(kBsonArrayKey), header.begin() + 5);
+        out.write(header.data(), header.size());
+        break;
+    }
+    }
+}
+
+std::string RecipeWriter::encode(RecipeFormat format, const nlohmann::json &recipe) {
+    std::string bytes;
+    switch (format) {
+    case RecipeFormat::Json: {
+        // Indented one level, so the array matches dump(4) of the whole catalog
+        std::string element = recipe.dump(4);
+        bytes.reserve(element.size() + element.size() / 8);
+        for (char c : element) {
+            bytes += c;
+            if (c == '\n') {
+                bytes += "    ";
+            }
+        }
+        break;
+    }
+    case RecipeFormat::Ndjson:
+        bytes = recipe.dump(); // Newlines in strings are escaped
+        break;
+    case RecipeFormat::Cbor:
+        nlohmann::json::to_cbor(recipe, bytes);
+        break;
+    case RecipeFormat::MessagePack:
+        nlohmann::json::to_msgpack(recipe, bytes);
+        break;
+    case RecipeFormat::Bson:
+        nlohmann::json::to_bson(recipe, bytes);
+        break;
+    }
+    return bytes;
+}
+
+void RecipeWriter::write(const nlohmann::json &recipe) {
+    std::string element = encode(format, recipe);
+    writeEncoded(element.data(), element.size());
+}
+
+void RecipeWriter::writeEncoded(const char *data, size_t size) {
+    if (format == RecipeFormat::Json) {
+        out << (count == 0 ? "[\n    " : ",\n    ");
+    } else if (format == RecipeFormat::Bson) {
+        std::string key = std::to_string(count);
+        out.put('\x03'); // Embedded document keyed by its index
+        out.write(key.c_str(), key.size() + 1);
+        bytes += 1 + key.size() + 1;
+    }
+    out.write(data, size);
+    if (format == RecipeFormat::Ndjson) {
+        out.put('\n');
+    }
+    bytes += size;
+    ++count;
+}
+
+bool RecipeWriter::finish() {
+    switch (format) {
+    case RecipeFormat::Json:
+        out << (count == 0 ? "[]" : "\n]");
+        break;
+    case RecipeFormat::Ndjson:
+        break;
+    case RecipeFormat::Cbor:
+        out.put(static_cast<char>(0xff)); // Break
+        break;
+    case RecipeFormat::MessagePack:
+        break;
+    case RecipeFormat::Bson: {
+        out.put('\0'); // End of array
+        out.put('\0'); // End of document
+        std::string lengths(kBsonHeaderSize, '\0');
+        putInt32(lengths, 0, static_cast<uint32_t>(kBsonHeaderSize + bytes + 2));
+        putInt32(lengths, kBsonHeaderSize - 4, static_cast<uint32_t>(4 + bytes + 1));
+        std::streamoff end = out.tellp();
+        out.seekp(start);
+        out.write(lengths.data(), 4);
+        out.seekp(start + static_cast<std::streamoff>(kBsonHeaderSize - 4));
+        out.write(lengths.data() + kBsonHeaderSize - 4, 4);
+        out.seekp(end);
+        break;
+    }
+    }
+    out.flush();
+    return static_cast<bool>(out);
+}
+
+bool readRecipes(std::istream &in, RecipeFormat format, const std::function<bool(nlohmann::json &&)> &onRecipe) {
+    if (format == RecipeFormat::Ndjson) {
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                continue;
+            }
+            nlohmann::json recipe = nlohmann::json::parse(line, nullptr, false);
+            if (recipe.is_discarded() || !onRecipe(std::move(recipe))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Bson wraps the array in a document, so elements sit one level deeper
+    RecipeArraySax sax(format == RecipeFormat::Bson ? 2 : 1, onRecipe);
+    switch (format) {
+    case RecipeFormat::Cbor:
+        return nlohmann::json::sax_parse(in, &sax, nlohmann::json::input_format_t::cbor);
+    case RecipeFormat::MessagePack:
+        return nlohmann::json::sax_parse(in, &sax, nlohmann::json::input_format_t::msgpack);
+    case RecipeFormat::Bson:
+        return nlohmann::json::sax_parse(in, &sax, nlohmann::json::input_format_t::bson);
+    case RecipeFormat::Json:
+    case RecipeFormat::Ndjson:
+        break;
+    }
+    return nlohmann::json::sax_parse(in, &sax, nlohmann::json::input_format_t::json);
+}
@@ -0,0 +1,53 @@
+#ifndef RECIPEFORMAT_H
+#define RECIPEFORMAT_H
+
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <nlohmann/json.hpp>
+
+// File formats for exporting and importing the recipe catalog.
+// Every format holds the same array of recipe objects (name, ingredients,
+// category, instructions, favorite). Json matches the original pretty-printed
+// export; the binary formats are smaller and much faster to parse. Ndjson
+// holds one compact recipe object per line, so files can be appended to,
+// split, tailed and read from any line boundary.
+enum class RecipeFormat { Json, Ndjson, Cbor, MessagePack, Bson };
+
+// Pick a format from the file extension (.ndjson/.jsonl, .cbor,
+// .msgpack/.mpk, .bson); anything else is Json
+RecipeFormat recipeFormatForPath(const std::string &path);
+
+// Writes a recipe array one element at a time, so an export never holds the
+// whole catalog in memory
+class RecipeWriter {
+public:
+    RecipeWriter(std::ostream &out, RecipeFormat format);
+
+    // MessagePack stores the element count up front; the other formats
+    // ignore it. Bson patches its length fields in finish(), so its stream
+    // must be seekable.
+    void begin(size_t count);
+    void write(const nlohmann::json &recipe);
+    bool finish();
+
+    // Split form of write() for encoding on other threads: encode() has no
+    // position-dependent bytes, writeEncoded() adds the separator or key
+    static std::string encode(RecipeFormat format, const nlohmann::json &recipe);
+    void writeEncoded(const char *data, size_t size);
+
+private:
+    std::ostream &out;
+    RecipeFormat format;
+    size_t count = 0;
+    std::streamoff start = 0;
+    size_t bytes = 0; // Bson: element bytes written so far
+};
+
+// Parse a recipe array without building it as a whole, calling onRecipe for
+// each element; onRecipe returns false to stop. Returns false if the input
+// is malformed or onRecipe stopped early.
+bool readRecipes(std::istream &in, RecipeFormat format, const std::function<bool(nlohmann::json &&)> &onRecipe);
+
+#endif // RECIPEFORMAT_H
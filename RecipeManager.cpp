@@ -1,309 +1,2703 @@
 #include "RecipeManager.h"
+#include "ImportPipeline.h"
+#include "MaintenanceScheduler.h"
+#include "MealJsonReader.h"
+#include "SchemaMigrator.h"
+#include "StartupProfiler.h"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
 #include <cctype>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <fstream>
-#include <curl/curl.h>
+#include <iterator>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <nlohmann/json.hpp>
-#include <gtk/gtk.h>
 
-// Helper function to copy text to clipboard
-void copy_to_clipboard(GtkWidget *widget, gpointer user_data) {
-    const char *text = static_cast<const char *>(user_data);
-    GtkClipboard *clipboard = gtk_clipboard_get(GDK_SELECTION_CLIPBOARD);
-    gtk_clipboard_set_text(clipboard, text, -1);
+// Helper Function: Convert to Lowercase
+std::string toLower(const std::string &str) {
+    std::string result = str;
+    std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+    return result;
+}
+
+// Helper Function: Trim Whitespace
+std::string trim(const std::string &str) {
+    size_t start = str.find_first_not_of(" \t");
+    size_t end = str.find_last_not_of(" \t");
+    return (start == std::string::npos) ? "" : str.substr(start, end - start + 1);
+}
+
+// Helper Function: Store ingredients as one comma-separated column
+std::string joinIngredients(const std::vector<std::string> &ingredients) {
+    std::ostringstream oss;
+    for (size_t i = 0; i < ingredients.size(); ++i) {
+        oss << ingredients[i];
+        if (i < ingredients.size() - 1) {
+            oss << ",";
+        }
+    }
+    return oss.str();
+}
+
+// Helper Function: Split the stored ingredient column into a vector
+static std::vector<std::string> splitIngredients(const std::string &ingredientsStr) {
+    std::vector<std::string> ingredients;
+    std::istringstream iss(ingredientsStr);
+    std::string ingredient;
+    while (std::getline(iss, ingredient, ',')) {
+        ingredients.push_back(trim(ingredient));
+    }
+    return ingredients;
+}
+
+// Helper Function: Unique key for a recipe name (case and spacing ignored)
+std::string recipeNameKey(const std::string &name) {
+    std::string key;
+    key.reserve(name.size());
+    bool pendingSpace = false;
+    for (unsigned char c : name) {
+        if (std::isspace(c)) {
+            pendingSpace = !key.empty();
+            continue;
+        }
+        if (pendingSpace) {
+            key += ' ';
+            pendingSpace = false;
+        }
+        key += static_cast<char>(std::tolower(c));
+    }
+    return key;
+}
+
+// Helper Function: 64-bit FNV-1a hash of everything stored for a recipe
+int64_t recipeContentHash(const std::string &name, const std::string &ingredients, const std::string &category, const std::string &instructions, bool favorite) {
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](const std::string &field) {
+        for (unsigned char c : field) {
+            hash = (hash ^ c) * 1099511628211ULL;
+        }
+        hash = (hash ^ 0x1f) * 1099511628211ULL; // Field separator
+    };
+    mix(name);
+    mix(ingredients);
+    mix(category);
+    mix(instructions);
+    hash = (hash ^ (favorite ? '1' : '0')) * 1099511628211ULL;
+    return static_cast<int64_t>(hash);
+}
+
+// Helper Function: Read a TEXT argument of a SQL function as std::string
+static std::string textArg(sqlite3_value *value) {
+    const unsigned char *text = sqlite3_value_text(value);
+    return text ? std::string(reinterpret_cast<const char *>(text), sqlite3_value_bytes(value)) : std::string();
+}
+
+// SQL Function: recipe_name_key(name)
+static void sqlRecipeNameKey(sqlite3_context *context, int, sqlite3_value **argv) {
+    std::string key = recipeNameKey(textArg(argv[0]));
+    sqlite3_result_text(context, key.c_str(), static_cast<int>(key.size()), SQLITE_TRANSIENT);
+}
+
+// SQL Function: recipe_hash(name, ingredients, category, instructions, favorite)
+static void sqlRecipeHash(sqlite3_context *context, int, sqlite3_value **argv) {
+    sqlite3_result_int64(context, recipeContentHash(textArg(argv[0]), textArg(argv[1]), textArg(argv[2]),
+                                                    textArg(argv[3]), sqlite3_value_int(argv[4]) != 0));
+}
+
+// SQL Function: recipe_has_ingredient(ingredients, ingredient_key), for rows
+// whose ingredients haven't been moved to recipe_ingredients yet
+static void sqlRecipeHasIngredient(sqlite3_context *context, int, sqlite3_value **argv) {
+    std::string key = textArg(argv[1]);
+    bool found = false;
+    for (const std::string &ingredient : splitIngredients(textArg(argv[0]))) {
+        if (recipeNameKey(ingredient) == key) {
+            found = true;
+            break;
+        }
+    }
+    sqlite3_result_int(context, found);
+}
+
+// Helper Class: Groups writes atomically. On an idle connection it opens its
+// own IMMEDIATE transaction; inside an open batch it becomes a savepoint.
+class WriteScope {
+public:
+    WriteScope(sqlite3 *db, const char *name) : db(db), name(name) {
+        nested = db && !sqlite3_get_autocommit(db);
+        std::string sql = nested ? "SAVEPOINT " + this->name + ";" : "BEGIN IMMEDIATE;";
+        active = db && sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK;
+        if (!active) {
+            std::cerr << "Failed to begin " << this->name << ": " << sqlite3_errmsg(db) << std::endl;
+        }
+    }
+
+    ~WriteScope() {
+        if (active) {
+            rollback();
+        }
+    }
+
+    bool ok() const { return active; }
+
+    bool commit() {
+        if (!active) {
+            return false;
+        }
+        std::string sql = nested ? "RELEASE " + name + ";" : "COMMIT;";
+        if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK) {
+            std::cerr << "Failed to commit " << name << ": " << sqlite3_errmsg(db) << std::endl;
+            rollback();
+            return false;
+        }
+        active = false;
+        return true;
+    }
+
+    void rollback() {
+        std::string sql = nested ? "ROLLBACK TO " + name + "; RELEASE " + name + ";" : "ROLLBACK;";
+        sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
+        active = false;
+    }
+
+private:
+    sqlite3 *db;
+    std::string name;
+    bool nested = false;
+    bool active = false;
+};
+
+// Helper Class: Keeps one read transaction open so several statements see
+// the same snapshot. Inside an open transaction it does nothing.
+class ReadScope {
+public:
+    explicit ReadScope(sqlite3 *db) : db(db) {
+        owned = db && sqlite3_get_autocommit(db) && sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr) == SQLITE_OK;
+    }
+
+    ~ReadScope() {
+        if (owned) {
+            sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+        }
+    }
+
+private:
+    sqlite3 *db;
+    bool owned = false;
+};
+
+// Constructor: Initialize the SQLite Database
+RecipeManager::RecipeManager(const std::string &dbPath, OpenMode mode)
+    : dbPath(dbPath), mealDb(std::make_unique<MealDbClient>(MealDbClient::Options())) {
+    if (mode == OpenMode::Immediate) {
+        ensureOpen();
+    }
+}
+
+// Start opening the database without blocking the caller
+void RecipeManager::openInBackground() {
+    if (!openThread.joinable()) {
+        openThread = std::thread([this] { ensureOpen(); });
+    }
+}
+
+// Block until the database has been opened exactly once
+void RecipeManager::ensureOpen() const {
+    std::call_once(openFlag, [this] { openDatabase(); });
+}
+
+// Maximum number of SQLite connections shared by all threads
+static const size_t kMaxConnections = 8;
+
+// Per-connection setup shared by the pool and the write queue
+static void configureConnection(sqlite3 *db) {
+    // Only takes effect on a new database, before WAL mode and the first
+    // table: pages of cleared recipes can then go back with incremental_vacuum
+    sqlite3_exec(db, "PRAGMA auto_vacuum = INCREMENTAL;", nullptr, nullptr, nullptr);
+
+    // WAL lets readers on other connections proceed while one thread writes
+    sqlite3_exec(db, "PRAGMA journal_mode=WAL;", nullptr, nullptr, nullptr);
+
+    // Same key and hash as the C++ helpers, so SQL and import agree
+    int flags = SQLITE_UTF8 | SQLITE_DETERMINISTIC;
+    sqlite3_create_function(db, "recipe_name_key", 1, flags, nullptr, sqlRecipeNameKey, nullptr, nullptr);
+    sqlite3_create_function(db, "recipe_hash", 5, flags, nullptr, sqlRecipeHash, nullptr, nullptr);
+    sqlite3_create_function(db, "recipe_has_ingredient", 2, flags, nullptr, sqlRecipeHasIngredient, nullptr, nullptr);
+}
+
+// Helper Function: Check whether a table already has a column
+static bool hasColumn(sqlite3 *db, const char *table, const char *column) {
+    std::string sql = std::string("PRAGMA table_info(") + table + ");";
+    sqlite3_stmt *stmt;
+    bool found = false;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+        while (!found && sqlite3_step(stmt) == SQLITE_ROW) {
+            found = std::strcmp(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1)), column) == 0;
+        }
+        sqlite3_finalize(stmt);
+    }
+    return found;
+}
+
+// Maintenance Task: Delete the rows of cleared generations once the undo
+// window has passed, in chunks until the slice deadline
+static MaintenanceScheduler::Slice reclaimSlice(sqlite3 *db, std::chrono::steady_clock::time_point deadline, std::chrono::seconds undoWindow) {
+    MaintenanceScheduler::Slice slice;
+    const char *pendingSQL = R"(
+        SELECT EXISTS (SELECT 1 FROM recipes WHERE generation < m.generation),
+               m.undo_generation IS NOT NULL,
+               m.cleared_at - CAST(strftime('%s', 'now') AS INTEGER)
+        FROM recipe_meta AS m;
+    )";
+    sqlite3_stmt *stmt;
+    bool pending = false;
+    int64_t waitSeconds = 0;
+    if (sqlite3_prepare_v2(db, pendingSQL, -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            pending = sqlite3_column_int(stmt, 0) != 0;
+            if (sqlite3_column_int(stmt, 1) != 0) {
+                waitSeconds = std::max<int64_t>(0, sqlite3_column_int64(stmt, 2) + undoWindow.count());
+            }
+        }
+        sqlite3_finalize(stmt);
+    }
+    if (!pending) {
+        return slice;
+    }
+    if (waitSeconds > 0) {
+        slice.retryIn = std::chrono::seconds(waitSeconds);
+        return slice;
+    }
+
+    // The first deletion ends the chance to undo
+    WriteScope scope(db, "reclaim_recipes");
+    const char *deleteSQL = R"(
+        DELETE FROM recipes WHERE id IN (
+            SELECT id FROM recipes WHERE generation < (SELECT generation FROM recipe_meta) LIMIT 500);
+    )";
+    if (!scope.ok() ||
+        sqlite3_exec(db, "UPDATE recipe_meta SET undo_generation = NULL;", nullptr, nullptr, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, deleteSQL, -1, &stmt, nullptr) != SQLITE_OK) {
+        slice.failed = true;
+        slice.detail = sqlite3_errmsg(db);
+        return slice;
+    }
+    int deleted = 0;
+    int chunk = 0;
+    do {
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            slice.failed = true;
+            slice.detail = sqlite3_errmsg(db);
+            break;
+        }
+        chunk = sqlite3_changes(db);
+        deleted += chunk;
+        sqlite3_reset(stmt);
+    } while (chunk == 500 && std::chrono::steady_clock::now() < deadline);
+    sqlite3_finalize(stmt);
+
+    if (slice.failed || !scope.commit()) {
+        slice.failed = true;
+        return slice;
+    }
+    slice.worked = true;
+    slice.more = chunk == 500;
+    slice.detail = "deleted " + std::to_string(deleted) + " cleared recipes";
+    return slice;
+}
+
+// Maintenance Task: Refresh the query planner statistics after enough
+// writes, counted by the change log
+static MaintenanceScheduler::Slice analyzeSlice(sqlite3 *db) {
+    const int64_t kAnalyzeAfterChanges = 1000;
+    MaintenanceScheduler::Slice slice;
+    const char *churnSQL = R"(
+        SELECT COALESCE((SELECT seq FROM sqlite_sequence WHERE name = 'recipe_changes'), 0), analyzed_seq FROM recipe_meta;
+    )";
+    sqlite3_stmt *stmt;
+    int64_t seq = 0;
+    int64_t analyzedSeq = 0;
+    if (sqlite3_prepare_v2(db, churnSQL, -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            seq = sqlite3_column_int64(stmt, 0);
+            analyzedSeq = sqlite3_column_int64(stmt, 1);
+        }
+        sqlite3_finalize(stmt);
+    }
+    if (seq - analyzedSeq < kAnalyzeAfterChanges) {
+        return slice;
+    }
+
+    // analysis_limit samples large indexes instead of reading them whole
+    std::string analyzeSQL = "PRAGMA analysis_limit = 1000; ANALYZE; UPDATE recipe_meta SET analyzed_seq = " + std::to_string(seq) + ";";
+    if (sqlite3_exec(db, analyzeSQL.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK) {
+        slice.failed = true;
+        slice.detail = sqlite3_errmsg(db);
+        return slice;
+    }
+    slice.worked = true;
+    slice.detail = "analyzed after " + std::to_string(seq - analyzedSeq) + " changes";
+    return slice;
+}
+
+// Maintenance Task: Compact the change log. Delta export only reads the
+// last change of each name and the last clear, so every earlier row for a
+// name, and everything before a clear, is deleted. The log is walked in
+// ranges of sequence numbers from recipe_meta.compacted_seq: each row in a
+// range removes the rows it supersedes, in chunks until the slice deadline.
+static MaintenanceScheduler::Slice compactChangesSlice(sqlite3 *db, std::chrono::steady_clock::time_point deadline) {
+    const int64_t kCompactAfterChanges = 1000;
+    const int kChunkSize = 500;
+    MaintenanceScheduler::Slice slice;
+    const char *rangeSQL = R"(
+        SELECT COALESCE((SELECT seq FROM sqlite_sequence WHERE name = 'recipe_changes'), 0), compacted_seq FROM recipe_meta;
+    )";
+    sqlite3_stmt *stmt;
+    int64_t seq = 0;
+    int64_t compactedSeq = 0;
+    if (sqlite3_prepare_v2(db, rangeSQL, -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            seq = sqlite3_column_int64(stmt, 0);
+            compactedSeq = sqlite3_column_int64(stmt, 1);
+        }
+        sqlite3_finalize(stmt);
+    }
+    if (seq - compactedSeq < kCompactAfterChanges) {
+        return slice;
+    }
+
+    const char *deleteSQL = R"(
+        DELETE FROM recipe_changes WHERE seq IN (
+            SELECT old.seq FROM recipe_changes AS new
+            JOIN recipe_changes AS old ON old.name_key = new.name_key AND old.seq < new.seq
+            WHERE new.seq > ?1 AND new.seq <= ?2
+            UNION
+            SELECT seq FROM recipe_changes
+            WHERE seq < (SELECT MAX(seq) FROM recipe_changes WHERE seq > ?1 AND seq <= ?2 AND op = 'clear')
+            LIMIT ?3);
+    )";
+    WriteScope scope(db, "compact_changes");
+    sqlite3_stmt *markStmt = nullptr;
+    if (!scope.ok() ||
+        sqlite3_prepare_v2(db, deleteSQL, -1, &stmt, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, "UPDATE recipe_meta SET compacted_seq = ?;", -1, &markStmt, nullptr) != SQLITE_OK) {
+        slice.failed = true;
+        slice.detail = sqlite3_errmsg(db);
+        sqlite3_finalize(stmt);
+        return slice;
+    }
+
+    int deleted = 0;
+    int chunk = 0;
+    do {
+        int64_t rangeEnd = std::min(compactedSeq + kCompactAfterChanges, seq);
+        sqlite3_bind_int64(stmt, 1, compactedSeq);
+        sqlite3_bind_int64(stmt, 2, rangeEnd);
+        sqlite3_bind_int(stmt, 3, kChunkSize);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            slice.failed = true;
+            slice.detail = sqlite3_errmsg(db);
+            break;
+        }
+        chunk = sqlite3_changes(db);
+        deleted += chunk;
+        sqlite3_reset(stmt);
+
+        // The range is done once a chunk comes back short
+        if (chunk < kChunkSize) {
+            compactedSeq = rangeEnd;
+            sqlite3_bind_int64(markStmt, 1, compactedSeq);
+            if (sqlite3_step(markStmt) != SQLITE_DONE) {
+                slice.failed = true;
+                slice.detail = sqlite3_errmsg(db);
+                break;
+            }
+            sqlite3_reset(markStmt);
+        }
+    } while (compactedSeq < seq && std::chrono::steady_clock::now() < deadline);
+    sqlite3_finalize(stmt);
+    sqlite3_finalize(markStmt);
+
+    if (slice.failed || !scope.commit()) {
+        slice.failed = true;
+        return slice;
+    }
+    slice.worked = true;
+    slice.more = compactedSeq < seq;
+    slice.detail = "deleted " + std::to_string(deleted) + " superseded changes";
+    return slice;
+}
+
+// Maintenance Task: Move the ingredients of recipes that haven't been
+// moved yet (schema version 7) into recipe_ingredients, in chunks until the
+// slice deadline
+static MaintenanceScheduler::Slice migrateIngredientsSlice(sqlite3 *db, std::chrono::steady_clock::time_point deadline) {
+    const size_t kChunkSize = 200;
+    MaintenanceScheduler::Slice slice;
+    const char *pendingSQL = R"(
+        SELECT id, ingredients FROM recipes
+        WHERE ingredients_migrated = 0 AND generation = (SELECT generation FROM recipe_meta)
+        ORDER BY id LIMIT ?;
+    )";
+    const char *insertSQL = "INSERT INTO recipe_ingredients (recipe_id, position, ingredient, ingredient_key) VALUES (?, ?, ?, ?);";
+    const char *markSQL = "UPDATE recipes SET ingredients_migrated = 1 WHERE id = ?;";
+
+    WriteScope scope(db, "migrate_ingredients");
+    sqlite3_stmt *pendingStmt = nullptr;
+    sqlite3_stmt *insertStmt = nullptr;
+    sqlite3_stmt *markStmt = nullptr;
+    if (!scope.ok() ||
+        sqlite3_prepare_v2(db, pendingSQL, -1, &pendingStmt, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, insertSQL, -1, &insertStmt, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, markSQL, -1, &markStmt, nullptr) != SQLITE_OK) {
+        slice.failed = true;
+        slice.detail = sqlite3_errmsg(db);
+        sqlite3_finalize(pendingStmt);
+        sqlite3_finalize(insertStmt);
+        sqlite3_finalize(markStmt);
+        return slice;
+    }
+    sqlite3_bind_int(pendingStmt, 1, static_cast<int>(kChunkSize));
+
+    int migrated = 0;
+    size_t chunk = 0;
+    do {
+        // Read the whole chunk before writing to the table it comes from
+        std::vector<std::pair<int64_t, std::string>> rows;
+        while (sqlite3_step(pendingStmt) == SQLITE_ROW) {
+            rows.emplace_back(sqlite3_column_int64(pendingStmt, 0),
+                              reinterpret_cast<const char *>(sqlite3_column_text(pendingStmt, 1)));
+        }
+        sqlite3_reset(pendingStmt);
+        chunk = rows.size();
+
+        for (const auto &row : rows) {
+            int position = 0;
+            for (const std::string &ingredient : splitIngredients(row.second)) {
+                if (ingredient.empty()) {
+                    continue;
+                }
+                std::string key = recipeNameKey(ingredient);
+                sqlite3_bind_int64(insertStmt, 1, row.first);
+                sqlite3_bind_int(insertStmt, 2, position++);
+                sqlite3_bind_text(insertStmt, 3, ingredient.c_str(), -1, SQLITE_TRANSIENT);
+                sqlite3_bind_text(insertStmt, 4, key.c_str(), -1, SQLITE_TRANSIENT);
+                if (sqlite3_step(insertStmt) != SQLITE_DONE) {
+                    slice.failed = true;
+                }
+                sqlite3_reset(insertStmt);
+            }
+            sqlite3_bind_int64(markStmt, 1, row.first);
+            if (sqlite3_step(markStmt) != SQLITE_DONE) {
+                slice.failed = true;
+            }
+            sqlite3_reset(markStmt);
+            if (slice.failed) {
+                slice.detail = sqlite3_errmsg(db);
+                break;
+            }
+            ++migrated;
+        }
+    } while (!slice.failed && chunk == kChunkSize && std::chrono::steady_clock::now() < deadline);
+    sqlite3_finalize(pendingStmt);
+    sqlite3_finalize(insertStmt);
+    sqlite3_finalize(markStmt);
+
+    if (slice.failed || !scope.commit()) {
+        slice.failed = true;
+        return slice;
+    }
+    slice.worked = migrated > 0;
+    slice.more = chunk == kChunkSize;
+    slice.detail = "moved the ingredients of " + std::to_string(migrated) + " recipes";
+    return slice;
+}
+
+// Helper Function: Make names unique before they become the key (schema
+// version 2). Rows sharing a name with an older row are merged into it when
+// their fields don't conflict: empty fields are filled in and the favorite
+// flag is kept. A row whose content differs is renamed "Name (2)", "Name (3)",
+// ... instead, so nothing the user entered is lost.
+static bool mergeDuplicateNames(sqlite3 *db) {
+    struct Row {
+        int64_t id;
+        std::string name;
+        std::string fields[3]; // ingredients, category, instructions
+        bool favorite;
+        std::string key;
+    };
+    const char *selectSQL = R"(
+        SELECT id, name, ingredients, category, instructions, favorite, name_key FROM recipes
+        WHERE name_key IN (SELECT name_key FROM recipes GROUP BY name_key HAVING COUNT(*) > 1)
+        ORDER BY name_key, id;
+    )";
+    std::vector<Row> rows;
+    std::unordered_set<std::string> keys;
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, selectSQL, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    auto text = [&](int column) {
+        const unsigned char *value = sqlite3_column_text(stmt, column);
+        return value ? std::string(reinterpret_cast<const char *>(value)) : std::string();
+    };
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        rows.push_back(Row{sqlite3_column_int64(stmt, 0), text(1), {text(2), text(3), text(4)}, sqlite3_column_int(stmt, 5) != 0, text(6)});
+    }
+    sqlite3_finalize(stmt);
+    if (rows.empty()) {
+        return true;
+    }
+    if (sqlite3_prepare_v2(db, "SELECT DISTINCT name_key FROM recipes;", -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        keys.insert(text(0));
+    }
+    sqlite3_finalize(stmt);
+
+    sqlite3_stmt *mergeStmt = nullptr;
+    sqlite3_stmt *deleteStmt = nullptr;
+    sqlite3_stmt *renameStmt = nullptr;
+    bool ok = sqlite3_prepare_v2(db, "UPDATE recipes SET ingredients = ?, category = ?, instructions = ?, favorite = ? WHERE id = ?;", -1, &mergeStmt, nullptr) == SQLITE_OK &&
+              sqlite3_prepare_v2(db, "DELETE FROM recipes WHERE id = ?;", -1, &deleteStmt, nullptr) == SQLITE_OK &&
+              sqlite3_prepare_v2(db, "UPDATE recipes SET name = ?, name_key = ? WHERE id = ?;", -1, &renameStmt, nullptr) == SQLITE_OK;
+    auto run = [&](sqlite3_stmt *write) {
+        ok = ok && sqlite3_step(write) == SQLITE_DONE;
+        sqlite3_reset(write);
+    };
+
+    size_t merged = 0;
+    size_t renamed = 0;
+    for (size_t first = 0; ok && first < rows.size();) {
+        size_t end = first + 1;
+        while (end < rows.size() && rows[end].key == rows[first].key) {
+            ++end;
+        }
+        Row &kept = rows[first];
+        for (size_t i = first + 1; ok && i < end; ++i) {
+            Row &row = rows[i];
+            bool conflict = false;
+            for (int field = 0; field < 3; ++field) {
+                conflict = conflict || (!kept.fields[field].empty() && !row.fields[field].empty() && kept.fields[field] != row.fields[field]);
+            }
+            if (conflict) {
+                std::string name;
+                for (int copy = 2; name.empty() || keys.count(recipeNameKey(name)); ++copy) {
+                    name = row.name + " (" + std::to_string(copy) + ")";
+                }
+                std::string key = recipeNameKey(name);
+                keys.insert(key);
+                sqlite3_bind_text(renameStmt, 1, name.c_str(), -1, SQLITE_TRANSIENT);
+                sqlite3_bind_text(renameStmt, 2, key.c_str(), -1, SQLITE_TRANSIENT);
+                sqlite3_bind_int64(renameStmt, 3, row.id);
+                run(renameStmt);
+                ++renamed;
+                continue;
+            }
+            for (int field = 0; field < 3; ++field) {
+                if (kept.fields[field].empty()) {
+                    kept.fields[field] = row.fields[field];
+                }
+            }
+            kept.favorite = kept.favorite || row.favorite;
+            sqlite3_bind_int64(deleteStmt, 1, row.id);
+            run(deleteStmt);
+            ++merged;
+        }
+        for (int field = 0; field < 3; ++field) {
+            sqlite3_bind_text(mergeStmt, field + 1, kept.fields[field].c_str(), -1, SQLITE_TRANSIENT);
+        }
+        sqlite3_bind_int(mergeStmt, 4, kept.favorite ? 1 : 0);
+        sqlite3_bind_int64(mergeStmt, 5, kept.id);
+        run(mergeStmt);
+        first = end;
+    }
+    sqlite3_finalize(mergeStmt);
+    sqlite3_finalize(deleteStmt);
+    sqlite3_finalize(renameStmt);
+
+    if (ok) {
+        std::cerr << "Recipe names are now unique: merged " << merged << " duplicate recipes into the older copy, renamed "
+                  << renamed << " whose content differed" << std::endl;
+    }
+    return ok;
+}
+
+// Schema: every version of the database layout, oldest first. Add a step
+// for each change; never edit a step that has shipped.
+static SchemaMigrator recipeSchema() {
+    SchemaMigrator schema;
+
+    schema.add(1, "recipes table", SchemaMigrator::sql(R"(
+        CREATE TABLE IF NOT EXISTS recipes (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            name TEXT NOT NULL,
+            ingredients TEXT NOT NULL,
+            category TEXT NOT NULL,
+            instructions TEXT NOT NULL DEFAULT '',
+            favorite INTEGER DEFAULT 0
+        );
+    )"));
+
+    // Names become unique: add the key and hash columns and fill them in.
+    // Rows sharing a name are merged into the oldest one, or renamed if
+    // their content differs (see mergeDuplicateNames).
+    schema.add(2, "unique recipe names", [](sqlite3 *db) {
+        if (hasColumn(db, "recipes", "name_key")) {
+            return true;
+        }
+        return sqlite3_exec(db, R"(
+            ALTER TABLE recipes ADD COLUMN name_key TEXT;
+            ALTER TABLE recipes ADD COLUMN content_hash INTEGER;
+            UPDATE recipes SET name_key = recipe_name_key(name);
+        )", nullptr, nullptr, nullptr) == SQLITE_OK &&
+               mergeDuplicateNames(db) &&
+               sqlite3_exec(db, "UPDATE recipes SET content_hash = recipe_hash(name, ingredients, category, instructions, favorite);",
+                            nullptr, nullptr, nullptr) == SQLITE_OK;
+    });
+
+    // Clearing starts a new generation; rows of older generations are
+    // invisible and are deleted in the background, and names are unique per
+    // generation. undo_generation is the generation undoClear() can bring
+    // back; it is reset once reclamation starts deleting it.
+    schema.add(3, "recipe generations", [](sqlite3 *db) {
+        if (!hasColumn(db, "recipes", "generation") &&
+            sqlite3_exec(db, R"(
+                ALTER TABLE recipes ADD COLUMN generation INTEGER NOT NULL DEFAULT 0;
+                DROP INDEX IF EXISTS idx_recipes_name_key;
+                DROP TRIGGER IF EXISTS recipes_log_delete;
+            )", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            return false;
+        }
+        return sqlite3_exec(db, R"(
+            CREATE TABLE IF NOT EXISTS recipe_meta (
+                id INTEGER PRIMARY KEY CHECK (id = 1),
+                generation INTEGER NOT NULL,
+                undo_generation INTEGER,
+                cleared_at INTEGER
+            );
+            INSERT OR IGNORE INTO recipe_meta (id, generation) VALUES (1, 0);
+            CREATE VIEW IF NOT EXISTS live_recipes AS
+                SELECT * FROM recipes WHERE generation = (SELECT generation FROM recipe_meta);
+            CREATE UNIQUE INDEX IF NOT EXISTS idx_recipes_generation_key ON recipes(generation, name_key);
+        )", nullptr, nullptr, nullptr) == SQLITE_OK;
+    });
+
+    // Change log position of the last ANALYZE
+    schema.add(4, "statistics refresh counter", [](sqlite3 *db) {
+        return hasColumn(db, "recipe_meta", "analyzed_seq") ||
+               sqlite3_exec(db, "ALTER TABLE recipe_meta ADD COLUMN analyzed_seq INTEGER NOT NULL DEFAULT 0;", nullptr, nullptr, nullptr) == SQLITE_OK;
+    });
+
+    // Change log for delta export: triggers record every write with an
+    // increasing sequence number. A new log starts with one 'insert' per
+    // existing recipe so a copy synced from seq 0 receives everything. A
+    // rename changes the key, so the old key is logged as deleted. Rows of
+    // cleared generations are removed without logging: the clear is logged.
+    schema.add(5, "change log", [](sqlite3 *db) {
+        if (!hasColumn(db, "recipe_changes", "seq") &&
+            sqlite3_exec(db, R"(
+                CREATE TABLE IF NOT EXISTS recipe_changes (
+                    seq INTEGER PRIMARY KEY AUTOINCREMENT,
+                    recipe_id INTEGER NOT NULL,
+                    name_key TEXT NOT NULL,
+                    op TEXT NOT NULL
+                );
+                CREATE INDEX IF NOT EXISTS idx_recipe_changes_name_key ON recipe_changes(name_key, seq);
+                INSERT INTO recipe_changes (recipe_id, name_key, op)
+                    SELECT id, name_key, 'insert' FROM live_recipes ORDER BY id;
+            )", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            return false;
+        }
+        return sqlite3_exec(db, R"(
+            CREATE TRIGGER IF NOT EXISTS recipes_log_insert AFTER INSERT ON recipes
+            BEGIN
+                INSERT INTO recipe_changes (recipe_id, name_key, op) VALUES (new.id, new.name_key, 'insert');
+            END;
+            CREATE TRIGGER IF NOT EXISTS recipes_log_update AFTER UPDATE ON recipes
+            WHEN old.name IS NOT new.name OR old.ingredients IS NOT new.ingredients
+              OR old.category IS NOT new.category OR old.instructions IS NOT new.instructions
+            BEGIN
+                INSERT INTO recipe_changes (recipe_id, name_key, op)
+                    SELECT old.id, old.name_key, 'delete' WHERE old.name_key IS NOT new.name_key;
+                INSERT INTO recipe_changes (recipe_id, name_key, op) VALUES (new.id, new.name_key, 'update');
+            END;
+            CREATE TRIGGER IF NOT EXISTS recipes_log_favorite AFTER UPDATE OF favorite ON recipes
+            WHEN old.favorite IS NOT new.favorite
+             AND old.name IS new.name AND old.ingredients IS new.ingredients
+             AND old.category IS new.category AND old.instructions IS new.instructions
+            BEGIN
+                INSERT INTO recipe_changes (recipe_id, name_key, op) VALUES (new.id, new.name_key, 'favorite');
+            END;
+            CREATE TRIGGER IF NOT EXISTS recipes_log_delete AFTER DELETE ON recipes
+            WHEN old.generation = (SELECT generation FROM recipe_meta)
+            BEGIN
+                INSERT INTO recipe_changes (recipe_id, name_key, op) VALUES (old.id, old.name_key, 'delete');
+            END;
+        )", nullptr, nullptr, nullptr) == SQLITE_OK;
+    });
+
+    // Position of each unfinished checkpointed import, saved with its batch
+    schema.add(6, "import checkpoints", SchemaMigrator::sql(R"(
+        CREATE TABLE IF NOT EXISTS import_checkpoints (
+            path TEXT PRIMARY KEY,
+            fingerprint INTEGER NOT NULL,
+            byte_offset INTEGER NOT NULL,
+            records INTEGER NOT NULL,
+            batch_seq INTEGER NOT NULL
+        );
+    )"));
+
+    // One row per ingredient, indexed by its key. Existing recipes are moved
+    // over by the "ingredients" maintenance task; until a row has been moved
+    // (ingredients_migrated = 0) readers split the ingredients column
+    // instead. Writers keep writing that column, and a changed list sends the
+    // row back to the task.
+    schema.add(7, "ingredient table", [](sqlite3 *db) {
+        if (!hasColumn(db, "recipes", "ingredients_migrated") &&
+            sqlite3_exec(db, "ALTER TABLE recipes ADD COLUMN ingredients_migrated INTEGER NOT NULL DEFAULT 0;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            return false;
+        }
+        return sqlite3_exec(db, R"(
+            CREATE TABLE IF NOT EXISTS recipe_ingredients (
+                recipe_id INTEGER NOT NULL,
+                position INTEGER NOT NULL,
+                ingredient TEXT NOT NULL,
+                ingredient_key TEXT NOT NULL,
+                PRIMARY KEY (recipe_id, position)
+            ) WITHOUT ROWID;
+            CREATE INDEX IF NOT EXISTS idx_recipe_ingredients_key ON recipe_ingredients(ingredient_key, recipe_id);
+            CREATE INDEX IF NOT EXISTS idx_recipes_unmigrated ON recipes(generation, id) WHERE ingredients_migrated = 0;
+            CREATE TRIGGER IF NOT EXISTS recipes_ingredients_changed AFTER UPDATE OF ingredients ON recipes
+            WHEN old.ingredients IS NOT new.ingredients
+            BEGIN
+                DELETE FROM recipe_ingredients WHERE recipe_id = new.id;
+                UPDATE recipes SET ingredients_migrated = 0 WHERE id = new.id;
+            END;
+            CREATE TRIGGER IF NOT EXISTS recipes_ingredients_delete AFTER DELETE ON recipes
+            BEGIN
+                DELETE FROM recipe_ingredients WHERE recipe_id = old.id;
+            END;
+        )", nullptr, nullptr, nullptr) == SQLITE_OK;
+    });
+
+    // TheMealDB ID of recipes saved from the API, so later views of them are
+    // read locally
+    schema.add(8, "remote recipe ids", [](sqlite3 *db) {
+        if (!hasColumn(db, "recipes", "mealdb_id") &&
+            sqlite3_exec(db, "ALTER TABLE recipes ADD COLUMN mealdb_id INTEGER;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            return false;
+        }
+        return sqlite3_exec(db, R"(
+            CREATE INDEX IF NOT EXISTS idx_recipes_mealdb_id ON recipes(generation, mealdb_id) WHERE mealdb_id IS NOT NULL;
+        )", nullptr, nullptr, nullptr) == SQLITE_OK;
+    });
+
+    // Offline mirror of TheMealDB: validators of each enumerated page and the
+    // sync run that last applied it, so an interrupted run resumes. Pages
+    // applied to an older generation (before a clear) count as never seen.
+    schema.add(9, "TheMealDB mirror sync", SchemaMigrator::sql(R"(
+        CREATE TABLE IF NOT EXISTS mealdb_sync (
+            endpoint TEXT PRIMARY KEY,
+            etag TEXT NOT NULL DEFAULT '',
+            last_modified TEXT NOT NULL DEFAULT '',
+            run INTEGER NOT NULL,
+            generation INTEGER NOT NULL
+        );
+        CREATE TABLE IF NOT EXISTS mealdb_sync_state (
+            id INTEGER PRIMARY KEY CHECK (id = 1),
+            run INTEGER NOT NULL,
+            finished INTEGER NOT NULL
+        );
+        INSERT OR IGNORE INTO mealdb_sync_state (id, run, finished) VALUES (1, 0, 1);
+    )"));
+
+    // Change log compaction: how far the log has been compacted, and an
+    // index that delta export reads instead of the whole log. Clears are
+    // left out of it; export looks them up separately.
+    schema.add(10, "change log compaction", [](sqlite3 *db) {
+        if (!hasColumn(db, "recipe_meta", "compacted_seq") &&
+            sqlite3_exec(db, "ALTER TABLE recipe_meta ADD COLUMN compacted_seq INTEGER NOT NULL DEFAULT 0;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            return false;
+        }
+        return sqlite3_exec(db, R"(
+            CREATE INDEX IF NOT EXISTS idx_recipe_changes_seq ON recipe_changes(seq, name_key) WHERE op <> 'clear';
+        )", nullptr, nullptr, nullptr) == SQLITE_OK;
+    });
+
+    // updateRecipe() keeps the ingredient rows of a patched recipe itself:
+    // it sets ingredients_migrated = 2 for the length of its transaction,
+    // and the trigger only handles the other writes
+    schema.add(11, "ingredient rows updated in place", SchemaMigrator::sql(R"(
+        DROP TRIGGER IF EXISTS recipes_ingredients_changed;
+        CREATE TRIGGER recipes_ingredients_changed AFTER UPDATE OF ingredients ON recipes
+        WHEN old.ingredients IS NOT new.ingredients AND new.ingredients_migrated IS NOT 2
+        BEGIN
+            DELETE FROM recipe_ingredients WHERE recipe_id = new.id;
+            UPDATE recipes SET ingredients_migrated = 0 WHERE id = new.id;
+        END;
+    )"));
+
+    // Recipes the mirror inserted, the only ones a sync may refresh. A
+    // recipe of the user linked to a TheMealDB ID by importRemoteRecipes()
+    // keeps its content. Rows saved before this step count as the user's.
+    schema.add(12, "mirrored recipes", [](sqlite3 *db) {
+        return hasColumn(db, "recipes", "mirrored") ||
+               sqlite3_exec(db, "ALTER TABLE recipes ADD COLUMN mirrored INTEGER NOT NULL DEFAULT 0;", nullptr, nullptr, nullptr) == SQLITE_OK;
+    });
+
+    return schema;
+}
+
+// Open the SQLite Database and bring its schema up to date
+void RecipeManager::openDatabase() const {
+    pool.reset(new ConnectionPool(dbPath, kMaxConnections, [this](sqlite3 *conn) {
+        configureConnection(conn);
+        recipeCache.attach(conn); // Writes on every connection evict what they change
+    }));
+
+    bool migrated = false;
+    {
+        ConnectionPool::Lease db = pool->acquire();
+        if (db) {
+            StartupProfiler::mark("sqlite3_open");
+            migrated = recipeSchema().migrate(db); // Reports a failed step itself
+        }
+    }
+    if (!migrated) {
+        // Without a pool every call fails instead of using a layout this
+        // build doesn't know
+        std::cerr << "Failed to open database " << dbPath << std::endl;
+        pool.reset();
+        return;
+    }
+    StartupProfiler::mark("schema migrated");
+
+    // Upkeep while the app is idle; the first round also finishes reclaiming
+    // a clear from an earlier session
+    maintenance.reset(new MaintenanceScheduler(*pool, writeMutex, MaintenanceScheduler::Options()));
+    maintenance->addTask("reclaim", true, [this](sqlite3 *conn, std::chrono::steady_clock::time_point deadline) {
+        return reclaimSlice(conn, deadline, clearUndoWindow.load());
+    });
+    maintenance->addTask("ingredients", true, [](sqlite3 *conn, std::chrono::steady_clock::time_point deadline) {
+        return migrateIngredientsSlice(conn, deadline);
+    });
+    maintenance->addTask("changes", true, [](sqlite3 *conn, std::chrono::steady_clock::time_point deadline) {
+        return compactChangesSlice(conn, deadline);
+    });
+    maintenance->addTask("analyze", true, [](sqlite3 *conn, std::chrono::steady_clock::time_point) {
+        return analyzeSlice(conn);
+    });
+    maintenance->start();
+    StartupProfiler::mark("maintenance started");
+}
+
+// Borrow a connection, opening the database first if needed; a lease on
+// nullptr if it couldn't be opened
+ConnectionPool::Lease RecipeManager::connection() const {
+    ensureOpen();
+    if (maintenance) {
+        maintenance->noteActivity();
+    }
+    return pool ? pool->acquire() : ConnectionPool::Lease();
+}
+
+// Destructor: Close the SQLite Database
+RecipeManager::~RecipeManager() {
+    {
+        // Waits for a search delivering right now; later ones deliver nothing
+        std::unique_lock<std::shared_mutex> lock(searchLifeline->mutex);
+        searchLifeline->alive = false;
+    }
+    if (openThread.joinable()) {
+        openThread.join();
+    }
+    maintenance.reset(); // Stops after the current slice; the next session continues
+    mealDb.reset(); // Fails queued API requests and joins their threads
+    writeQueue.reset(); // Commits queued writes before the pool goes away
+    pool.reset();
+}
+
+// Helper Function: Read a row of (name, ingredients, category, instructions,
+// favorite[, id])
+static Recipe recipeFromRow(sqlite3_stmt *stmt) {
+    Recipe recipe;
+    recipe.name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+    recipe.ingredients = splitIngredients(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1)));
+    recipe.category = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2));
+    recipe.instructions = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3));
+    recipe.isFavorite = sqlite3_column_int(stmt, 4);
+    if (sqlite3_column_count(stmt) > 5) {
+        recipe.id = sqlite3_column_int(stmt, 5);
+    }
+    return recipe;
+}
+
+// Helper Function: Insert one recipe row on the given connection
+static bool insertRecipe(sqlite3 *db, const std::string &name, const std::vector<std::string> &ingredients, const std::string &category, const std::string &instructions) {
+    std::string ingredientsStr = joinIngredients(ingredients);
+
+    const char *insertSQL = R"(
+        INSERT INTO recipes (name, ingredients, category, instructions, name_key, content_hash, generation)
+        VALUES (?1, ?2, ?3, ?4, recipe_name_key(?1), recipe_hash(?1, ?2, ?3, ?4, 0), (SELECT generation FROM recipe_meta));
+    )";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, insertSQL, -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, ingredientsStr.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, category.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 4, instructions.c_str(), -1, SQLITE_STATIC);
+
+        if (sqlite3_step(stmt) == SQLITE_DONE) {
+            sqlite3_finalize(stmt);
+            return true;
+        } else {
+            std::cerr << "Failed to add recipe: " << sqlite3_errmsg(db) << std::endl;
+        }
+
+        sqlite3_finalize(stmt);
+    } else {
+        std::cerr << "Failed to prepare insert statement: " << sqlite3_errmsg(db) << std::endl;
+    }
+    return false;
+}
+
+// Helper Function: Prepare the upsert used by upsertRecipeRow(). Inserts a
+// recipe or updates the row with the same name key; rows whose content hash
+// already matches are left untouched.
+static sqlite3_stmt *prepareUpsert(sqlite3 *db) {
+    const char *upsertSQL = R"(
+        INSERT INTO recipes (name, ingredients, category, instructions, favorite, name_key, content_hash, generation)
+        VALUES (?1, ?2, ?3, ?4, ?5, recipe_name_key(?1), recipe_hash(?1, ?2, ?3, ?4, ?5), (SELECT generation FROM recipe_meta))
+        ON CONFLICT(generation, name_key) DO UPDATE SET
+            name = excluded.name,
+            ingredients = excluded.ingredients,
+            category = excluded.category,
+            instructions = excluded.instructions,
+            favorite = excluded.favorite,
+            content_hash = excluded.content_hash
+        WHERE content_hash IS NOT excluded.content_hash;
+    )";
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v2(db, upsertSQL, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare upsert statement: " << sqlite3_errmsg(db) << std::endl;
+        return nullptr;
+    }
+    return stmt;
+}
+
+// Helper Function: Run a prepared upsert for one recipe
+static RecipeManager::UpsertResult upsertRecipeRow(sqlite3 *db, sqlite3_stmt *stmt, const PreparedRecipe &prepared) {
+    const Recipe &recipe = prepared.recipe;
+    sqlite3_bind_text(stmt, 1, recipe.name.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, prepared.ingredients.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, recipe.category.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, recipe.instructions.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 5, recipe.isFavorite ? 1 : 0);
+
+    RecipeManager::UpsertResult result = RecipeManager::UpsertResult::Failed;
+    if (sqlite3_step(stmt) == SQLITE_DONE) {
+        result = sqlite3_changes(db) > 0 ? RecipeManager::UpsertResult::Written : RecipeManager::UpsertResult::Unchanged;
+    } else {
+        std::cerr << "Failed to upsert recipe: " << sqlite3_errmsg(db) << std::endl;
+    }
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    return result;
+}
+
+// Helper Function: Flip the favorite flag on the given connection
+static bool toggleFavoriteRow(sqlite3 *db, const std::string &name) {
+    const char *updateSQL = R"(
+        UPDATE recipes
+        SET favorite = NOT favorite,
+            content_hash = recipe_hash(name, ingredients, category, instructions, NOT favorite)
+        WHERE generation = (SELECT generation FROM recipe_meta) AND name_key = recipe_name_key(?);
+    )";
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, updateSQL, -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
+
+        if (sqlite3_step(stmt) == SQLITE_DONE) {
+            sqlite3_finalize(stmt);
+            return true;
+        } else {
+            std::cerr << "Failed to update favorite status: " << sqlite3_errmsg(db) << std::endl;
+        }
+
+        sqlite3_finalize(stmt);
+    } else {
+        std::cerr << "Failed to prepare update statement: " << sqlite3_errmsg(db) << std::endl;
+    }
+    return false;
+}
+
+// Add a Recipe
+bool RecipeManager::addRecipe(const std::string &name, const std::vector<std::string> &ingredients, const std::string &category, const std::string &instructions) {
+    std::lock_guard<std::recursive_mutex> writeLock(writeMutex);
+    ConnectionPool::Lease db = connection();
+    return insertRecipe(db, name, ingredients, category, instructions);
+}
+
+// Insert or Update a Recipe by Name (idempotent)
+RecipeManager::UpsertResult RecipeManager::upsertRecipe(const Recipe &recipe) {
+    std::lock_guard<std::recursive_mutex> writeLock(writeMutex);
+    ConnectionPool::Lease db = connection();
+    sqlite3_stmt *stmt = prepareUpsert(db);
+    if (!stmt) {
+        return UpsertResult::Failed;
+    }
+    UpsertResult result = upsertRecipeRow(db, stmt, prepareRecipe(recipe));
+    sqlite3_finalize(stmt);
+    return result;
+}
+
+// Helper Function: Bring the recipe_ingredients rows of a moved recipe
+// (schema version 7) from the stored ingredients to the updated ones, after
+// an UPDATE that set ingredients_migrated = 2 to skip the trigger. A patch
+// only removes ingredients and appends new ones, so the rows of the removed
+// ones are deleted and the appended ones inserted after the last position.
+// Rows that don't match the stored list are dropped, and the recipe goes
+// back to the maintenance task, as the trigger would have done.
+static bool updateIngredientRows(sqlite3 *db, int id, const std::string &storedIngredients, const std::string &ingredients) {
+    auto items = [](const std::string &column) {
+        std::vector<std::string> listed;
+        for (std::string &ingredient : splitIngredients(column)) {
+            if (!ingredient.empty()) {
+                listed.push_back(std::move(ingredient));
+            }
+        }
+        return listed;
+    };
+    std::vector<std::string> before = items(storedIngredients);
+    std::vector<std::string> after = items(ingredients);
+
+    sqlite3_stmt *stmt;
+    std::vector<std::pair<int, std::string>> rows;
+    const char *rowsSQL = "SELECT position, ingredient FROM recipe_ingredients WHERE recipe_id = ? ORDER BY position;";
+    if (sqlite3_prepare_v2(db, rowsSQL, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare ingredient statement: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    sqlite3_bind_int(stmt, 1, id);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        rows.emplace_back(sqlite3_column_int(stmt, 0), reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1)));
+    }
+    sqlite3_finalize(stmt);
+
+    bool matches = rows.size() == before.size();
+    for (size_t i = 0; matches && i < rows.size(); ++i) {
+        matches = rows[i].second == before[i];
+    }
+    if (!matches) {
+        std::string resetSQL = "DELETE FROM recipe_ingredients WHERE recipe_id = " + std::to_string(id) +
+                               "; UPDATE recipes SET ingredients_migrated = 0 WHERE id = " + std::to_string(id) + ";";
+        return sqlite3_exec(db, resetSQL.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK;
+    }
+
+    sqlite3_stmt *deleteStmt = nullptr;
+    sqlite3_stmt *insertStmt = nullptr;
+    const char *deleteSQL = "DELETE FROM recipe_ingredients WHERE recipe_id = ? AND position = ?;";
+    const char *insertSQL = "INSERT INTO recipe_ingredients (recipe_id, position, ingredient, ingredient_key) VALUES (?, ?, ?, ?);";
+    bool ok = sqlite3_prepare_v2(db, deleteSQL, -1, &deleteStmt, nullptr) == SQLITE_OK &&
+              sqlite3_prepare_v2(db, insertSQL, -1, &insertStmt, nullptr) == SQLITE_OK;
+
+    // Stored ingredients missing from the updated list in order were removed;
+    // whatever is left of the updated list was appended
+    size_t kept = 0;
+    for (size_t i = 0; ok && i < before.size(); ++i) {
+        if (kept < after.size() && after[kept] == before[i]) {
+            ++kept;
+            continue;
+        }
+        sqlite3_bind_int(deleteStmt, 1, id);
+        sqlite3_bind_int(deleteStmt, 2, rows[i].first);
+        ok = sqlite3_step(deleteStmt) == SQLITE_DONE;
+        sqlite3_reset(deleteStmt);
+    }
+    int position = rows.empty() ? 0 : rows.back().first + 1;
+    for (size_t i = kept; ok && i < after.size(); ++i) {
+        std::string key = recipeNameKey(after[i]);
+        sqlite3_bind_int(insertStmt, 1, id);
+        sqlite3_bind_int(insertStmt, 2, position++);
+        sqlite3_bind_text(insertStmt, 3, after[i].c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(insertStmt, 4, key.c_str(), -1, SQLITE_TRANSIENT);
+        ok = sqlite3_step(insertStmt) == SQLITE_DONE;
+        sqlite3_reset(insertStmt);
+    }
+    sqlite3_finalize(deleteStmt);
+    sqlite3_finalize(insertStmt);
+
+    std::string markSQL = "UPDATE recipes SET ingredients_migrated = 1 WHERE id = " + std::to_string(id) + ";";
+    ok = ok && sqlite3_exec(db, markSQL.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK;
+    if (!ok) {
+        std::cerr << "Failed to update ingredients: " << sqlite3_errmsg(db) << std::endl;
+    }
+    return ok;
+}
+
+// Update a Recipe by ID. Only the columns whose value changes appear in the
+// UPDATE, and a patch that changes nothing writes nothing.
+RecipeManager::UpsertResult RecipeManager::updateRecipe(int id, const RecipePatch &patch) {
+    std::lock_guard<std::recursive_mutex> writeLock(writeMutex);
+    ConnectionPool::Lease db = connection();
+    WriteScope scope(db, "update_recipe");
+    if (!scope.ok()) {
+        return UpsertResult::Failed;
+    }
+
+    // The stored values are needed anyway: the content hash covers every column
+    const char *selectSQL = "SELECT name, ingredients, category, instructions, favorite, id, ingredients_migrated FROM live_recipes WHERE id = ?;";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, selectSQL, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare select statement: " << sqlite3_errmsg(db) << std::endl;
+        return UpsertResult::Failed;
+    }
+    sqlite3_bind_int(stmt, 1, id);
+    if (sqlite3_step(stmt) != SQLITE_ROW) {
+        std::cerr << "Failed to update recipe: no recipe with id " << id << std::endl;
+        sqlite3_finalize(stmt);
+        return UpsertResult::Failed;
+    }
+    Recipe stored = recipeFromRow(stmt);
+    std::string storedIngredients = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+    bool ingredientsMoved = sqlite3_column_int(stmt, 6) == 1;
+    sqlite3_finalize(stmt);
+
+    Recipe updated = stored;
+    updated.name = patch.name ? trim(*patch.name) : stored.name;
+    updated.category = patch.category.value_or(stored.category);
+    updated.instructions = patch.instructions.value_or(stored.instructions);
+    updated.isFavorite = patch.isFavorite.value_or(stored.isFavorite);
+    if (updated.name.empty()) {
+        std::cerr << "Failed to update recipe: the name can't be empty" << std::endl;
+        return UpsertResult::Failed;
+    }
+
+    auto listed = [&](const std::string &key) {
+        return std::find_if(updated.ingredients.begin(), updated.ingredients.end(), [&](const std::string &ingredient) {
+            return recipeNameKey(ingredient) == key;
+        });
+    };
+    for (const std::string &ingredient : patch.removeIngredients) {
+        auto found = listed(recipeNameKey(ingredient));
+        if (found != updated.ingredients.end()) {
+            updated.ingredients.erase(found);
+        }
+    }
+    for (const std::string &ingredient : patch.addIngredients) {
+        std::string trimmed = trim(ingredient);
+        if (!trimmed.empty() && listed(recipeNameKey(trimmed)) == updated.ingredients.end()) {
+            updated.ingredients.push_back(trimmed);
+        }
+    }
+    std::string ingredients = joinIngredients(updated.ingredients);
+
+    // Every value is bound, but only the dirty columns are assigned
+    std::string assignments;
+    auto assign = [&](bool dirty, const char *assignment) {
+        if (dirty) {
+            assignments += (assignments.empty() ? "" : ", ") + std::string(assignment);
+        }
+    };
+    assign(updated.name != stored.name, "name = ?1");
+    assign(recipeNameKey(updated.name) != recipeNameKey(stored.name), "name_key = recipe_name_key(?1)");
+    assign(ingredients != storedIngredients, "ingredients = ?2");
+    assign(ingredients != storedIngredients && ingredientsMoved, "ingredients_migrated = 2"); // Rows updated below
+    assign(updated.category != stored.category, "category = ?3");
+    assign(updated.instructions != stored.instructions, "instructions = ?4");
+    assign(updated.isFavorite != stored.isFavorite, "favorite = ?5");
+    if (assignments.empty()) {
+        scope.commit();
+        return UpsertResult::Unchanged;
+    }
+
+    std::string updateSQL = "UPDATE recipes SET " + assignments + ", content_hash = ?6 WHERE id = ?7;";
+    if (sqlite3_prepare_v2(db, updateSQL.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare update statement: " << sqlite3_errmsg(db) << std::endl;
+        return UpsertResult::Failed;
+    }
+    sqlite3_bind_text(stmt, 1, updated.name.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, ingredients.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, updated.category.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 4, updated.instructions.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 5, updated.isFavorite ? 1 : 0);
+    sqlite3_bind_int64(stmt, 6, recipeContentHash(updated.name, ingredients, updated.category, updated.instructions, updated.isFavorite));
+    sqlite3_bind_int(stmt, 7, id);
+
+    bool written = sqlite3_step(stmt) == SQLITE_DONE;
+    if (!written) {
+        std::cerr << "Failed to update recipe: " << sqlite3_errmsg(db) << std::endl;
+    }
+    sqlite3_finalize(stmt);
+    if (written && ingredients != storedIngredients && ingredientsMoved) {
+        written = updateIngredientRows(db, id, storedIngredients, ingredients);
+    }
+    return written && scope.commit() ? UpsertResult::Written : UpsertResult::Failed;
+}
+
+// Add a Recipe through the group-commit queue
+std::future<bool> RecipeManager::addRecipeAsync(const std::string &name, const std::vector<std::string> &ingredients, const std::string &category, const std::string &instructions) {
+    return submitWrite([=](sqlite3 *db) {
+        return insertRecipe(db, name, ingredients, category, instructions);
+    });
+}
+
+// API Integration: Recipes in a {"meals": [...]} response. filter.php only
+// sends id, name and thumbnail; search.php and lookup.php send the whole
+// recipe. Only these fields are decoded; the rest of each meal is skipped.
+std::vector<Recipe> recipesFromMealJson(std::string_view body) {
+    enum Field { Id, Name, Category, Instructions, Thumbnail, FirstIngredient };
+    static const std::vector<std::string> fields = [] {
+        std::vector<std::string> names = {"idMeal", "strMeal", "strCategory", "strInstructions", "strMealThumb"};
+        for (int i = 1; i <= 20; ++i) {
+            names.push_back("strIngredient" + std::to_string(i));
+        }
+        return names;
+    }();
+
+    std::vector<Recipe> recipes;
+    MealJsonReader meals(body, fields);
+    while (meals.nextMeal()) {
+        Recipe recipe;
+        recipe.id = std::atoi(meals.field(Id).c_str());
+        recipe.name = meals.field(Name);
+        recipe.category = meals.field(Category);
+        recipe.instructions = meals.field(Instructions);
+        recipe.thumbnailUrl = meals.field(Thumbnail);
+        for (size_t i = FirstIngredient; i < fields.size(); ++i) {
+            if (meals.has(i)) {
+                std::string ingredient = trim(meals.field(i));
+                if (!ingredient.empty()) {
+                    recipe.ingredients.push_back(ingredient);
+                }
+            }
+        }
+        if (recipe.id > 0 && !recipe.name.empty()) {
+            recipes.push_back(std::move(recipe));
+        }
+    }
+    if (!meals.ok()) {
+        recipes.clear(); // A cut-off body counts as a failed request, as a failed parse did
+    }
+    return recipes;
+}
+
+// API Integration: Recipes in a response; none if the request failed
+static std::vector<Recipe> recipesFromMeals(const MealDbClient::Response &response) {
+    return response ? recipesFromMealJson(*response) : std::vector<Recipe>();
+}
+
+// API Integration: Search recipes by ingredient
+std::vector<Recipe> RecipeManager::searchByIngredient(const std::string &ingredient) {
+    return recipesFromMeals(mealDb->get("filter.php?i=" + MealDbClient::encode(ingredient)));
+}
+
+// API Integration: Recipes that use every ingredient. TheMealDB filters by
+// one ingredient at a time, so the filters all go out at once and their ID
+// lists are intersected as they arrive. An empty or failed list ends the
+// search without waiting for the others.
+std::vector<Recipe> RecipeManager::searchByIngredients(const std::vector<std::string> &ingredients) {
+    // Filled by the response callbacks, which may run after this returns
+    struct Arrivals {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::deque<MealDbClient::Response> responses;
+    };
+    auto arrivals = std::make_shared<Arrivals>();
+    std::unordered_set<std::string> asked;
+    for (const std::string &ingredient : ingredients) {
+        // Same key for "Garlic" and "garlic ", so repeats share one request
+        std::string key = recipeNameKey(ingredient);
+        if (!key.empty() && asked.insert(key).second) {
+            // Ingredient lists change rarely, so a recent one is reused
+            mealDb->request("filter.php?i=" + MealDbClient::encode(key), [arrivals](const MealDbClient::Response &response) {
+                std::lock_guard<std::mutex> lock(arrivals->mutex);
+                arrivals->responses.push_back(response);
+                arrivals->changed.notify_one();
+            }, true);
+        }
+    }
+
+    auto byId = [](const Recipe &a, const Recipe &b) { return a.id < b.id; };
+    std::vector<Recipe> matches; // Sorted by ID
+    for (size_t received = 0; received < asked.size(); ++received) {
+        MealDbClient::Response body;
+        {
+            std::unique_lock<std::mutex> lock(arrivals->mutex);
+            arrivals->changed.wait(lock, [&] { return !arrivals->responses.empty(); });
+            body = std::move(arrivals->responses.front());
+            arrivals->responses.pop_front();
+        }
+        if (!body) {
+            return {}; // Unknown list; the client finishes the others for anyone else waiting
+        }
+        std::vector<Recipe> recipes = recipesFromMealJson(*body);
+        std::sort(recipes.begin(), recipes.end(), byId);
+        if (received == 0) {
+            matches = std::move(recipes);
+        } else {
+            std::vector<Recipe> kept;
+            std::set_intersection(matches.begin(), matches.end(), recipes.begin(), recipes.end(), std::back_inserter(kept), byId);
+            matches.swap(kept);
+        }
+        if (matches.empty()) {
+            return matches;
+        }
+    }
+    return matches;
+}
+
+// API Integration: Whole recipe by TheMealDB ID; recipes saved with
+// importRemoteRecipe() are read locally
+std::optional<Recipe> RecipeManager::getRemoteRecipe(int mealId) {
+    {
+        ConnectionPool::Lease db = connection();
+        sqlite3_stmt *stmt;
+        const char *selectSQL = "SELECT name, ingredients, category, instructions, favorite FROM live_recipes WHERE mealdb_id = ?;";
+        if (sqlite3_prepare_v2(db, selectSQL, -1, &stmt, nullptr) == SQLITE_OK) {
+            sqlite3_bind_int(stmt, 1, mealId);
+            std::optional<Recipe> saved;
+            if (sqlite3_step(stmt) == SQLITE_ROW) {
+                saved = recipeFromRow(stmt);
+                saved->id = mealId;
+            }
+            sqlite3_finalize(stmt);
+            if (saved) {
+                return saved;
+            }
+        } else {
+            std::cerr << "Failed to look up saved recipe: " << sqlite3_errmsg(db) << std::endl;
+        }
+    }
+
+    for (Recipe &recipe : recipesFromMeals(mealDb->get("lookup.php?i=" + std::to_string(mealId)))) {
+        if (recipe.id == mealId) {
+            return std::move(recipe);
+        }
+    }
+    return std::nullopt;
+}
+
+// API Integration: Fetch recipe instructions by ID
+std::string RecipeManager::getRecipeInstructions(int recipeID) {
+    std::optional<Recipe> recipe = getRemoteRecipe(recipeID);
+    return recipe ? recipe->instructions : "No instructions found.";
+}
+
+// API Integration: Save one TheMealDB recipe into the local catalog
+bool RecipeManager::importRemoteRecipe(int mealId) {
+    return importRemoteRecipes({mealId}) == 1;
+}
+
+// API Integration: Save TheMealDB recipes into the local catalog. Recipes
+// saved before are not fetched again; the rest are fetched side by side and
+// stored in one transaction. A saved recipe with the same name keeps its
+// content and is linked to the TheMealDB ID.
+size_t RecipeManager::importRemoteRecipes(const std::vector<int> &mealIds) {
+    std::unordered_set<int> saved;
+    std::vector<int> missing;
+    auto savedCount = [&] {
+        return static_cast<size_t>(std::count_if(mealIds.begin(), mealIds.end(), [&](int mealId) { return saved.count(mealId) > 0; }));
+    };
+    {
+        ConnectionPool::Lease db = connection();
+        sqlite3_stmt *stmt;
+        if (sqlite3_prepare_v2(db, "SELECT 1 FROM live_recipes WHERE mealdb_id = ?;", -1, &stmt, nullptr) != SQLITE_OK) {
+            std::cerr << "Failed to look up saved recipes: " << sqlite3_errmsg(db) << std::endl;
+            return 0;
+        }
+        std::unordered_set<int> seen;
+        for (int mealId : mealIds) {
+            if (!seen.insert(mealId).second) {
+                continue;
+            }
+            sqlite3_bind_int(stmt, 1, mealId);
+            if (sqlite3_step(stmt) == SQLITE_ROW) {
+                saved.insert(mealId);
+            } else {
+                missing.push_back(mealId);
+            }
+            sqlite3_reset(stmt);
+        }
+        sqlite3_finalize(stmt);
+    }
+    if (missing.empty()) {
+        return savedCount();
+    }
+
+    // The client runs the lookups concurrently within its rate limit
+    std::vector<std::shared_future<MealDbClient::Response>> responses;
+    for (int mealId : missing) {
+        responses.push_back(mealDb->request("lookup.php?i=" + std::to_string(mealId)));
+    }
+    std::vector<Recipe> fetched;
+    for (size_t i = 0; i < responses.size(); ++i) {
+        for (Recipe &recipe : recipesFromMeals(responses[i].get())) {
+            if (recipe.id == missing[i]) {
+                fetched.push_back(std::move(recipe));
+                break;
+            }
+        }
+    }
+    if (fetched.empty()) {
+        return savedCount();
+    }
+
+    std::lock_guard<std::recursive_mutex> writeLock(writeMutex);
+    ConnectionPool::Lease db = connection();
+    WriteScope scope(db, "import_remote_recipes");
+    if (!scope.ok()) {
+        return savedCount();
+    }
+    const char *upsertSQL = R"(
+        INSERT INTO recipes (name, ingredients, category, instructions, name_key, content_hash, generation, mealdb_id)
+        VALUES (?1, ?2, ?3, ?4, recipe_name_key(?1), recipe_hash(?1, ?2, ?3, ?4, 0), (SELECT generation FROM recipe_meta), ?5)
+        ON CONFLICT(generation, name_key) DO UPDATE SET mealdb_id = excluded.mealdb_id;
+    )";
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, upsertSQL, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare remote recipe insert: " << sqlite3_errmsg(db) << std::endl;
+        return savedCount();
+    }
+    for (const Recipe &recipe : fetched) {
+        std::string ingredientsStr = joinIngredients(recipe.ingredients);
+        sqlite3_bind_text(stmt, 1, recipe.name.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, ingredientsStr.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, recipe.category.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 4, recipe.instructions.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 5, recipe.id);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            std::cerr << "Failed to save remote recipe: " << sqlite3_errmsg(db) << std::endl;
+            sqlite3_finalize(stmt);
+            return savedCount();
+        }
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    if (scope.commit()) {
+        for (const Recipe &recipe : fetched) {
+            saved.insert(recipe.id);
+        }
+    }
+    return savedCount();
+}
+
+// Helper Function: Run work(0) .. work(count - 1) on up to `threads` threads
+static void forEachConcurrently(size_t count, size_t threads, const std::function<void(size_t)> &work) {
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        for (size_t i = next++; i < count; i = next++) {
+            work(i);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < std::min(std::max<size_t>(threads, 1), count); ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &thread : workers) {
+        thread.join();
+    }
+}
+
+// Mirror: Validators and progress of one enumerated page
+struct MirrorPage {
+    std::string etag;
+    std::string lastModified;
+    int64_t run = 0;
+    int64_t generation = -1;
+};
+
+// Mirror: Apply one page of TheMealDB recipes and mark it synced, in one
+// transaction, so a page is applied completely or redone by the next run.
+// Recipes the mirror inserted before are refreshed in place (renames
+// included); a recipe of the user, linked to the same ID or with the same
+// name, is left alone.
+static bool writeMirrorPage(sqlite3 *db, const std::string &endpoint, const std::vector<Recipe> &recipes,
+                            const MirrorPage &page, size_t &written) {
+    WriteScope scope(db, "mirror_page");
+    if (!scope.ok()) {
+        return false;
+    }
+    const char *updateSQL = R"(
+        UPDATE recipes SET name = ?1, ingredients = ?2, category = ?3, instructions = ?4,
+                           name_key = recipe_name_key(?1), content_hash = recipe_hash(?1, ?2, ?3, ?4, favorite)
+        WHERE generation = (SELECT generation FROM recipe_meta) AND mealdb_id = ?5 AND mirrored = 1
+          AND content_hash IS NOT recipe_hash(?1, ?2, ?3, ?4, favorite);
+    )";
+    const char *insertSQL = R"(
+        INSERT INTO recipes (name, ingredients, category, instructions, name_key, content_hash, generation, mealdb_id, mirrored)
+        SELECT ?1, ?2, ?3, ?4, recipe_name_key(?1), recipe_hash(?1, ?2, ?3, ?4, 0), (SELECT generation FROM recipe_meta), ?5, 1
+        WHERE NOT EXISTS (SELECT 1 FROM live_recipes WHERE mealdb_id = ?5)
+        ON CONFLICT DO NOTHING;
+    )";
+    sqlite3_stmt *update = nullptr;
+    sqlite3_stmt *insert = nullptr;
+    if (sqlite3_prepare_v2(db, updateSQL, -1, &update, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, insertSQL, -1, &insert, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare mirror statements: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_finalize(update);
+        return false;
+    }
+
+    for (const Recipe &recipe : recipes) {
+        std::string ingredientsStr = joinIngredients(recipe.ingredients);
+        for (sqlite3_stmt *stmt : {update, insert}) {
+            sqlite3_bind_text(stmt, 1, recipe.name.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 2, ingredientsStr.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 3, recipe.category.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 4, recipe.instructions.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int(stmt, 5, recipe.id);
+            int rc = sqlite3_step(stmt);
+            sqlite3_reset(stmt);
+            if (rc != SQLITE_DONE) {
+                // A rename onto a name that is taken; the rest of the page still applies
+                std::cerr << "Failed to mirror recipe " << recipe.id << ": " << sqlite3_errmsg(db) << std::endl;
+                break;
+            }
+            if (sqlite3_changes(db) > 0) {
+                ++written;
+                break;
+            }
+        }
+    }
+    sqlite3_finalize(update);
+    sqlite3_finalize(insert);
+
+    sqlite3_stmt *mark;
+    const char *markSQL = R"(
+        INSERT INTO mealdb_sync (endpoint, etag, last_modified, run, generation)
+        VALUES (?1, ?2, ?3, (SELECT run FROM mealdb_sync_state), (SELECT generation FROM recipe_meta))
+        ON CONFLICT(endpoint) DO UPDATE SET etag = excluded.etag, last_modified = excluded.last_modified,
+                                            run = excluded.run, generation = excluded.generation;
+    )";
+    if (sqlite3_prepare_v2(db, markSQL, -1, &mark, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare mirror progress: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    sqlite3_bind_text(mark, 1, endpoint.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(mark, 2, page.etag.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(mark, 3, page.lastModified.c_str(), -1, SQLITE_STATIC);
+    bool marked = sqlite3_step(mark) == SQLITE_DONE;
+    if (!marked) {
+        std::cerr << "Failed to save mirror progress: " << sqlite3_errmsg(db) << std::endl;
+    }
+    sqlite3_finalize(mark);
+    return marked && scope.commit();
 }
 
-// Static helper function for GTK callback
-static void on_activate(GtkApplication* app, gpointer user_data) {
-    const Recipe* recipe = static_cast<const Recipe*>(user_data);
+// Mirror: Copy the TheMealDB catalog into the local database. Pages are
+// enumerated by first letter; the category lists then find meals no letter
+// covers, which are looked up one by one. Each page is a conditional
+// request, so a refresh only downloads pages that changed. Progress is saved
+// per page, and a run that did not finish is resumed by the next call.
+RecipeManager::MirrorReport RecipeManager::syncMealDbMirror(const MirrorOptions &options) {
+    MirrorReport report;
+    int64_t run = 0;
+    int64_t generation = 0;
+    std::unordered_map<std::string, MirrorPage> pages;
+    {
+        std::lock_guard<std::recursive_mutex> writeLock(writeMutex);
+        ConnectionPool::Lease db = connection();
+        WriteScope scope(db, "mirror_start");
+        if (!scope.ok()) {
+            return report;
+        }
+        sqlite3_stmt *stmt;
+        if (sqlite3_exec(db, "UPDATE mealdb_sync_state SET run = run + 1, finished = 0 WHERE finished = 1;", nullptr, nullptr, nullptr) != SQLITE_OK ||
+            sqlite3_prepare_v2(db, "SELECT run, (SELECT generation FROM recipe_meta) FROM mealdb_sync_state;", -1, &stmt, nullptr) != SQLITE_OK) {
+            std::cerr << "Failed to start the mirror sync: " << sqlite3_errmsg(db) << std::endl;
+            return report;
+        }
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            run = sqlite3_column_int64(stmt, 0);
+            generation = sqlite3_column_int64(stmt, 1);
+        }
+        sqlite3_finalize(stmt);
+
+        if (sqlite3_prepare_v2(db, "SELECT endpoint, etag, last_modified, run, generation FROM mealdb_sync;", -1, &stmt, nullptr) == SQLITE_OK) {
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                MirrorPage &page = pages[reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0))];
+                page.etag = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+                page.lastModified = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2));
+                page.run = sqlite3_column_int64(stmt, 3);
+                page.generation = sqlite3_column_int64(stmt, 4);
+            }
+            sqlite3_finalize(stmt);
+        }
+        if (run == 0 || !scope.commit()) {
+            return report;
+        }
+    }
+
+    std::mutex reportMutex;
+    auto count = [&](size_t MirrorReport::*field, size_t amount) {
+        std::lock_guard<std::mutex> lock(reportMutex);
+        report.*field += amount;
+    };
+
+    // Fetch one page unless this run applied it already, then write it
+    auto syncPage = [&](const std::string &endpoint) {
+        MirrorPage page;
+        auto known = pages.find(endpoint);
+        if (known != pages.end() && known->second.generation == generation) {
+            if (known->second.run == run) {
+                count(&MirrorReport::skipped, 1);
+                return;
+            }
+            page = known->second;
+        }
+        MealDbClient::Fetched fetched = mealDb->fetch(endpoint, page.etag, page.lastModified);
+        if (fetched.status == MealDbClient::FetchStatus::Failed) {
+            count(&MirrorReport::failed, 1);
+            return;
+        }
+        std::vector<Recipe> recipes;
+        if (fetched.status == MealDbClient::FetchStatus::Fresh) {
+            recipes = recipesFromMeals(fetched.body);
+            page.etag = fetched.etag;
+            page.lastModified = fetched.lastModified;
+        }
 
-    GtkWidget* window = gtk_application_window_new(app);
-    gtk_window_set_title(GTK_WINDOW(window), "Recipe Viewer");
-    gtk_window_set_default_size(GTK_WINDOW(window), 400, 300);
+        size_t written = 0;
+        bool applied;
+        {
+            std::lock_guard<std::recursive_mutex> writeLock(writeMutex);
+            ConnectionPool::Lease db = connection();
+            applied = writeMirrorPage(db, endpoint, recipes, page, written);
+        }
+        count(&MirrorReport::written, written);
+        count(applied ? (fetched.status == MealDbClient::FetchStatus::Fresh ? &MirrorReport::pages : &MirrorReport::unchanged)
+                      : &MirrorReport::failed, 1);
+    };
 
-    GtkWidget* grid = gtk_grid_new();
-    gtk_container_add(GTK_CONTAINER(window), grid);
+    std::vector<std::string> letterPages;
+    for (char letter : options.letters) {
+        letterPages.push_back("search.php?f=" + MealDbClient::encode(std::string(1, letter)));
+    }
+    forEachConcurrently(letterPages.size(), options.threads, [&](size_t i) {
+        syncPage(letterPages[i]);
+    });
 
-    GtkWidget* labelName = gtk_label_new(("Name: " + recipe->name).c_str());
-    gtk_label_set_selectable(GTK_LABEL(labelName), TRUE);
-    gtk_grid_attach(GTK_GRID(grid), labelName, 0, 0, 1, 1);
+    if (options.categories) {
+        // Category lists are small and needed in full, so they are not conditional
+        std::vector<std::string> categoryPages;
+        MealDbClient::Fetched list = mealDb->fetch("list.php?c=list", std::string(), std::string());
+        if (list.status != MealDbClient::FetchStatus::Fresh) {
+            count(&MirrorReport::failed, 1);
+        } else {
+            static const std::vector<std::string> categoryField = {"strCategory"};
+            MealJsonReader categories(*list.body, categoryField);
+            while (categories.nextMeal()) {
+                if (categories.has(0)) {
+                    categoryPages.push_back("filter.php?c=" + MealDbClient::encode(categories.field(0)));
+                }
+            }
+        }
 
-    GtkWidget* labelInstructions = gtk_label_new(("Instructions: " + recipe->instructions).c_str());
-    gtk_label_set_selectable(GTK_LABEL(labelInstructions), TRUE);
-    gtk_grid_attach(GTK_GRID(grid), labelInstructions, 0, 1, 1, 1);
+        // Meals whose name starts with a character outside the letters
+        std::mutex uncoveredMutex;
+        std::set<int> uncovered;
+        forEachConcurrently(categoryPages.size(), options.threads, [&](size_t i) {
+            MealDbClient::Fetched listed = mealDb->fetch(categoryPages[i], std::string(), std::string());
+            if (listed.status != MealDbClient::FetchStatus::Fresh) {
+                count(&MirrorReport::failed, 1);
+                return;
+            }
+            for (const Recipe &meal : recipesFromMeals(listed.body)) {
+                char first = static_cast<char>(std::tolower(static_cast<unsigned char>(meal.name[0])));
+                if (options.letters.find(first) == std::string::npos) {
+                    std::lock_guard<std::mutex> lock(uncoveredMutex);
+                    uncovered.insert(meal.id);
+                }
+            }
+        });
 
-    GtkWidget* buttonCopyName = gtk_button_new_with_label("Copy Name");
-    g_signal_connect(buttonCopyName, "clicked", G_CALLBACK(copy_to_clipboard), (gpointer)recipe->name.c_str());
-    gtk_grid_attach(GTK_GRID(grid), buttonCopyName, 0, 2, 1, 1);
+        // No letter page lists them, so each is a conditional page of its own
+        std::vector<std::string> lookupPages;
+        for (int mealId : uncovered) {
+            lookupPages.push_back("lookup.php?i=" + std::to_string(mealId));
+        }
+        forEachConcurrently(lookupPages.size(), options.threads, [&](size_t i) {
+            syncPage(lookupPages[i]);
+        });
+        report.lookups = lookupPages.size();
+    }
 
-    GtkWidget* buttonCopyInstructions = gtk_button_new_with_label("Copy Instructions");
-    g_signal_connect(buttonCopyInstructions, "clicked", G_CALLBACK(copy_to_clipboard), (gpointer)recipe->instructions.c_str());
-    gtk_grid_attach(GTK_GRID(grid), buttonCopyInstructions, 0, 3, 1, 1);
+    if (report.failed == 0) {
+        std::lock_guard<std::recursive_mutex> writeLock(writeMutex);
+        ConnectionPool::Lease db = connection();
+        if (sqlite3_exec(db, "UPDATE mealdb_sync_state SET finished = 1;", nullptr, nullptr, nullptr) == SQLITE_OK) {
+            report.complete = true;
+        } else {
+            std::cerr << "Failed to finish the mirror sync: " << sqlite3_errmsg(db) << std::endl;
+        }
+    }
+    return report;
+}
 
-    gtk_widget_show_all(window);
+// API Integration: Change the TheMealDB rate limit and timeout
+void RecipeManager::configureMealDb(const MealDbClient::Options &options) {
+    mealDb->setOptions(options);
 }
 
-// Helper Function: Convert to Lowercase
-std::string toLower(const std::string &str) {
-    std::string result = str;
-    std::transform(result.begin(), result.end(), result.begin(), ::tolower);
-    return result;
+// API Integration: Requests made to TheMealDB and requests that shared one
+MealDbClient::Stats RecipeManager::mealDbStats() const {
+    return mealDb->stats();
 }
 
-// Helper Function: Trim Whitespace
-std::string trim(const std::string &str) {
-    size_t start = str.find_first_not_of(" \t");
-    size_t end = str.find_last_not_of(" \t");
-    return (start == std::string::npos) ? "" : str.substr(start, end - start + 1);
+// Federated Search: the remote requests start first, so the network round
+// trip overlaps the local queries
+void RecipeManager::searchAll(const std::string &query, const SearchOptions &options, SearchCallback onResults) const {
+    // Shared with the worker and the response callbacks; they may outlive
+    // this call (and this manager)
+    struct SearchState {
+        std::mutex mutex;
+        std::condition_variable changed;
+        bool localDone = false;
+        std::unordered_set<std::string> keys;    // Name keys delivered so far
+        std::vector<std::vector<Recipe>> arrived; // Responses not delivered yet
+        size_t waiting = 0;                       // Responses still to come
+    };
+    auto state = std::make_shared<SearchState>();
+    auto deadline = std::chrono::steady_clock::now() + options.deadline;
+
+    if (options.remote) {
+        // Identical searches running at the same time share these requests
+        std::vector<std::string> endpoints = {"filter.php?i=" + MealDbClient::encode(query),
+                                              "search.php?s=" + MealDbClient::encode(query)};
+        state->waiting = endpoints.size();
+        std::thread([state, deadline, onResults, lifeline = searchLifeline] {
+            // Nothing is delivered once the manager is gone
+            auto deliver = [&](const std::vector<Recipe> &recipes, bool last) {
+                std::shared_lock<std::shared_mutex> alive(lifeline->mutex);
+                if (lifeline->alive) {
+                    onResults(SearchSource::Remote, recipes, last);
+                }
+            };
+            // Local hits go first and decide which names are new, so hold
+            // back responses that arrive before they have been delivered.
+            // Responses still missing at the deadline are abandoned; the
+            // client finishes them for anyone else waiting.
+            std::unique_lock<std::mutex> lock(state->mutex);
+            while (true) {
+                bool expired = !state->changed.wait_until(lock, deadline, [&] {
+                    return state->localDone && (!state->arrived.empty() || state->waiting == 0);
+                });
+                state->changed.wait(lock, [&] { return state->localDone; });
+                std::vector<Recipe> fresh;
+                for (std::vector<Recipe> &recipes : state->arrived) {
+                    for (Recipe &recipe : recipes) {
+                        if (state->keys.insert(recipeNameKey(recipe.name)).second) {
+                            fresh.push_back(std::move(recipe));
+                        }
+                    }
+                }
+                state->arrived.clear();
+                bool last = expired || state->waiting == 0;
+                lock.unlock();
+                if (!fresh.empty()) {
+                    deliver(fresh, false);
+                }
+                if (last) {
+                    deliver({}, true);
+                    return;
+                }
+                lock.lock();
+            }
+        }).detach();
+        for (const std::string &endpoint : endpoints) {
+            mealDb->request(endpoint, [state](const MealDbClient::Response &response) {
+                std::vector<Recipe> recipes = recipesFromMeals(response);
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->arrived.push_back(std::move(recipes));
+                --state->waiting;
+                state->changed.notify_all();
+            });
+        }
+    }
+
+    std::vector<Recipe> local;
+    std::unordered_set<std::string> localKeys;
+    for (std::vector<Recipe> results : {searchLocalByName(query), searchLocalByIngredient(query)}) {
+        for (Recipe &recipe : results) {
+            if (localKeys.insert(recipeNameKey(recipe.name)).second) {
+                local.push_back(std::move(recipe));
+            }
+        }
+    }
+    onResults(SearchSource::Local, local, !options.remote);
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->keys = std::move(localKeys);
+    state->localDone = true;
+    state->changed.notify_all();
+}
+
+// List All Recipes
+std::vector<Recipe> RecipeManager::listAllRecipes() const {
+    ConnectionPool::Lease db = connection();
+    std::vector<Recipe> recipes;
+
+    const char *selectSQL = "SELECT name, ingredients, category, instructions, favorite, id FROM live_recipes;";
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2(db, selectSQL, -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            recipes.push_back(recipeFromRow(stmt));
+        }
+        sqlite3_finalize(stmt);
+    } else {
+        std::cerr << "Failed to retrieve recipes: " << sqlite3_errmsg(db) << std::endl;
+    }
+
+    return recipes;
+}
+
+// Find a Recipe's database ID by Name; 0 if there is none
+int RecipeManager::findRecipeId(const std::string &name) const {
+    ConnectionPool::Lease db = connection();
+    int id = 0;
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "SELECT id FROM live_recipes WHERE name_key = recipe_name_key(?);", -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            id = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    } else {
+        std::cerr << "Failed to look up recipe: " << sqlite3_errmsg(db) << std::endl;
+    }
+    return id;
+}
+
+// Get a Saved Recipe by ID, from the cache when possible
+std::optional<Recipe> RecipeManager::getRecipe(int id) const {
+    std::vector<Recipe> recipes = getRecipes({id});
+    if (recipes.empty()) {
+        return std::nullopt;
+    }
+    return std::move(recipes.front());
+}
+
+// Get Saved Recipes by ID, in the order asked for; IDs that don't exist are
+// skipped. Cached recipes are copied without touching the database, and the
+// rest are read with one query per 500 IDs.
+std::vector<Recipe> RecipeManager::getRecipes(const std::vector<int> &ids) const {
+    const size_t kIdsPerQuery = 500;
+    std::unordered_map<int, RecipeCache::Entry> found;
+    std::vector<int> missing;
+    std::vector<uint64_t> tokens;
+    for (int id : ids) {
+        if (found.count(id)) {
+            continue;
+        }
+        RecipeCache::Entry cached = recipeCache.get(id);
+        found[id] = cached;
+        if (!cached) {
+            missing.push_back(id);
+            tokens.push_back(recipeCache.token(id)); // Before the read, so a write in between is noticed
+        }
+    }
+
+    if (!missing.empty()) {
+        ConnectionPool::Lease db = connection();
+        ReadScope snapshot(db);
+        for (size_t start = 0; start < missing.size(); start += kIdsPerQuery) {
+            size_t count = std::min(kIdsPerQuery, missing.size() - start);
+            std::string selectSQL = "SELECT name, ingredients, category, instructions, favorite, id FROM live_recipes WHERE id IN (?";
+            for (size_t i = 1; i < count; ++i) {
+                selectSQL += ", ?";
+            }
+            selectSQL += ");";
+
+            sqlite3_stmt *stmt;
+            if (sqlite3_prepare_v2(db, selectSQL.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+                std::cerr << "Failed to retrieve recipes: " << sqlite3_errmsg(db) << std::endl;
+                break;
+            }
+            std::unordered_map<int, uint64_t> chunkTokens;
+            for (size_t i = 0; i < count; ++i) {
+                sqlite3_bind_int(stmt, static_cast<int>(i + 1), missing[start + i]);
+                chunkTokens[missing[start + i]] = tokens[start + i];
+            }
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                auto recipe = std::make_shared<const Recipe>(recipeFromRow(stmt));
+                recipeCache.put(recipe->id, recipe, chunkTokens[recipe->id]);
+                found[recipe->id] = std::move(recipe);
+            }
+            sqlite3_finalize(stmt);
+        }
+    }
+
+    std::vector<Recipe> recipes;
+    recipes.reserve(ids.size());
+    for (int id : ids) {
+        if (const RecipeCache::Entry &recipe = found[id]) {
+            recipes.push_back(*recipe);
+        }
+    }
+    return recipes;
+}
+
+// Resize the recipe cache; 0 turns it off
+void RecipeManager::setRecipeCacheCapacity(size_t capacity) {
+    recipeCache.setCapacity(capacity);
+}
+
+RecipeCache::Stats RecipeManager::recipeCacheStats() const {
+    return recipeCache.stats();
+}
+
+// Toggle Recipe as Favorite
+bool RecipeManager::toggleFavorite(const std::string &name) {
+    std::lock_guard<std::recursive_mutex> writeLock(writeMutex);
+    ConnectionPool::Lease db = connection();
+    return toggleFavoriteRow(db, name);
+}
+
+// Toggle Recipe as Favorite through the group-commit queue
+std::future<bool> RecipeManager::toggleFavoriteAsync(const std::string &name) {
+    return submitWrite([=](sqlite3 *db) {
+        return toggleFavoriteRow(db, name);
+    });
+}
+
+// Configure the group-commit queue; only possible before its first use
+bool RecipeManager::configureWriteQueue(const WriteQueue::Options &options) {
+    std::lock_guard<std::mutex> lock(writeQueueMutex);
+    if (writeQueue) {
+        return false;
+    }
+    writeQueueOptions = options;
+    return true;
+}
+
+// Submit a write to the group-commit queue, starting it on first use. Fails
+// at once if the database couldn't be opened.
+std::future<bool> RecipeManager::submitWrite(WriteQueue::Operation operation) {
+    ensureOpen();
+    if (!pool) {
+        std::promise<bool> failed;
+        failed.set_value(false);
+        return failed.get_future();
+    }
+    if (maintenance) {
+        maintenance->noteActivity();
+    }
+    std::lock_guard<std::mutex> lock(writeQueueMutex);
+    if (!writeQueue) {
+        writeQueue.reset(new WriteQueue(dbPath, writeMutex, writeQueueOptions, [this](sqlite3 *conn) {
+            configureConnection(conn);
+            recipeCache.attach(conn);
+        }));
+    }
+    return writeQueue->submit(std::move(operation));
+}
+
+// List Favorite Recipes
+std::string RecipeManager::listFavoriteRecipes() const {
+    ConnectionPool::Lease db = connection();
+    std::string favoriteList;
+    const char *selectSQL = "SELECT name, category FROM live_recipes WHERE favorite = 1;";
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2(db, selectSQL, -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            std::string name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+            std::string category = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+            favoriteList += name + " (" + category + ")\n";
+        }
+        sqlite3_finalize(stmt);
+    } else {
+        std::cerr << "Failed to retrieve favorite recipes: " << sqlite3_errmsg(db) << std::endl;
+    }
+
+    return favoriteList;
+}
+
+// Filter Recipes by Category
+std::string RecipeManager::filterRecipesByCategory(const std::string &category) const {
+    ConnectionPool::Lease db = connection();
+    std::string filteredList;
+    const char *selectSQL = "SELECT name, ingredients FROM live_recipes WHERE category = ?;";
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2(db, selectSQL, -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, category.c_str(), -1, SQLITE_STATIC);
+
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            std::string name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+            std::string ingredients = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+            filteredList += name + ": " + ingredients + "\n";
+        }
+        sqlite3_finalize(stmt);
+    } else {
+        std::cerr << "Failed to filter recipes: " << sqlite3_errmsg(db) << std::endl;
+    }
+
+    return filteredList;
+}
+
+// Search the Local Recipes by Ingredient (case and spacing ignored). Recipes
+// whose ingredients have been moved to recipe_ingredients are found through
+// its index; the rest, until the maintenance task reaches them, by splitting
+// their ingredients column.
+std::vector<Recipe> RecipeManager::searchLocalByIngredient(const std::string &ingredient) const {
+    ConnectionPool::Lease db = connection();
+    std::vector<Recipe> recipes;
+    const char *selectSQL = R"(
+        SELECT name, ingredients, category, instructions, favorite, id FROM live_recipes
+        WHERE id IN (SELECT recipe_id FROM recipe_ingredients WHERE ingredient_key = ?1)
+        UNION ALL
+        SELECT name, ingredients, category, instructions, favorite, id FROM live_recipes
+        WHERE ingredients_migrated = 0 AND recipe_has_ingredient(ingredients, ?1)
+        ORDER BY 6;
+    )";
+    std::string key = recipeNameKey(ingredient);
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2(db, selectSQL, -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_STATIC);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            recipes.push_back(recipeFromRow(stmt));
+        }
+        sqlite3_finalize(stmt);
+    } else {
+        std::cerr << "Failed to search recipes: " << sqlite3_errmsg(db) << std::endl;
+    }
+
+    return recipes;
+}
+
+// Search the Local Recipes by Name Prefix (case and spacing ignored), through
+// the (generation, name_key) index
+std::vector<Recipe> RecipeManager::searchLocalByName(const std::string &prefix) const {
+    std::vector<Recipe> recipes;
+    std::string key = recipeNameKey(prefix);
+    if (key.empty()) {
+        return recipes;
+    }
+    ConnectionPool::Lease db = connection();
+    const char *selectSQL = R"(
+        SELECT name, ingredients, category, instructions, favorite, id FROM live_recipes
+        WHERE name_key >= ?1 AND name_key < ?2 ORDER BY name_key;
+    )";
+    std::string end = key + '\xff'; // Sorts after every key starting with key
+    sqlite3_stmt *stmt;
+
+    if (sqlite3_prepare_v2(db, selectSQL, -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, end.c_str(), -1, SQLITE_STATIC);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            recipes.push_back(recipeFromRow(stmt));
+        }
+        sqlite3_finalize(stmt);
+    } else {
+        std::cerr << "Failed to search recipes: " << sqlite3_errmsg(db) << std::endl;
+    }
+
+    return recipes;
+}
+
+// Helper Function: Recipe object in the layout used by export files
+static nlohmann::json recipeToJson(const Recipe &recipe) {
+    nlohmann::json recipeJson;
+    recipeJson["name"] = recipe.name;
+    recipeJson["ingredients"] = recipe.ingredients;
+    recipeJson["category"] = recipe.category;
+    recipeJson["instructions"] = recipe.instructions;
+    recipeJson["favorite"] = recipe.isFavorite;
+    return recipeJson;
+}
+
+// Export Recipes (format chosen by file extension, JSON by default)
+bool RecipeManager::exportRecipes(const std::string &filePath) const {
+    return exportRecipes(filePath, recipeFormatForPath(filePath));
+}
+
+// Export Recipes, streaming one row at a time. Only NDJSON can be appended
+// to an existing file.
+bool RecipeManager::exportRecipes(const std::string &filePath, RecipeFormat format, bool append) const {
+    if (append && format != RecipeFormat::Ndjson) {
+        std::cerr << "Failed to export: only NDJSON files can be appended to." << std::endl;
+        return false;
+    }
+    std::ofstream outFile(filePath, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+    if (!outFile) {
+        std::cerr << "Failed to open file for export." << std::endl;
+        return false;
+    }
+
+    size_t threads = exportThreads ? exportThreads.load() : std::thread::hardware_concurrency();
+    threads = std::min(threads, kMaxConnections - 1); // This thread keeps one connection
+    if (threads > 1) {
+        // Lock before borrowing a connection, like every write path
+        std::unique_lock<std::recursive_mutex> writeLock(writeMutex);
+        ConnectionPool::Lease db = connection();
+        if (db && sqlite3_get_autocommit(db)) { // Other connections can't see an open batch
+            return exportRecipesParallel(db, writeLock, outFile, format, threads);
+        }
+    }
+
+    ConnectionPool::Lease db = connection();
+    ReadScope snapshot(db); // The count and the rows must agree
+
+    size_t count = 0;
+    sqlite3_stmt *stmt;
+    if (format == RecipeFormat::MessagePack &&
+        sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM live_recipes;", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            count = static_cast<size_t>(sqlite3_column_int64(stmt, 0));
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    const char *selectSQL = "SELECT name, ingredients, category, instructions, favorite FROM live_recipes ORDER BY id;";
+    if (sqlite3_prepare_v2(db, selectSQL, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to retrieve recipes: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+
+    RecipeWriter writer(outFile, format);
+    writer.begin(count);
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        writer.write(recipeToJson(recipeFromRow(stmt)));
+    }
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Failed to retrieve recipes: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    return writer.finish();
 }
 
-// Helper function to create a selectable label
-GtkWidget* create_selectable_label(const char* text) {
-    GtkWidget *label = gtk_label_new(text);
-    gtk_label_set_selectable(GTK_LABEL(label), TRUE); // Enable text selection
-    return label;
-}
+// Export Recipes on several threads. Workers serialize ranges of ids on
+// their own connections and the ranges are written in id order, so the file
+// is byte-identical to the single-threaded export. writeLock is held until
+// every worker has opened its read snapshot, so all of them see the same
+// data as this connection.
+bool RecipeManager::exportRecipesParallel(sqlite3 *db, std::unique_lock<std::recursive_mutex> &writeLock, std::ofstream &outFile, RecipeFormat format, size_t threads) const {
+    ReadScope snapshot(db);
+
+    size_t count = 0;
+    int64_t minId = 0;
+    int64_t maxId = -1;
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "SELECT COUNT(*), MIN(id), MAX(id) FROM live_recipes;", -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to retrieve recipes: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_int64(stmt, 0) > 0) {
+        count = static_cast<size_t>(sqlite3_column_int64(stmt, 0));
+        minId = sqlite3_column_int64(stmt, 1);
+        maxId = sqlite3_column_int64(stmt, 2);
+    }
+    sqlite3_finalize(stmt);
+
+    // Several ranges per worker, so an uneven id distribution still balances
+    size_t rangeCount = count == 0 ? 0 : std::min<size_t>(threads * 8, static_cast<size_t>(maxId - minId + 1));
+    int64_t rangeSize = rangeCount == 0 ? 0 : (maxId - minId) / static_cast<int64_t>(rangeCount) + 1;
+
+    struct Range {
+        std::string bytes;       // Encoded elements, back to back
+        std::vector<size_t> ends;
+        bool done = false;
+    };
+    std::vector<Range> ranges(rangeCount);
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_t started = 0;
+    size_t nextRange = 0;
+    size_t written = 0;
+    bool failed = false;
+    const size_t maxAhead = 2 * threads; // Ranges encoded but not yet written
+
+    auto worker = [&] {
+        ConnectionPool::Lease conn = pool->acquire();
+        sqlite3_stmt *select = nullptr;
+        bool ok = conn && sqlite3_exec(conn, "BEGIN;", nullptr, nullptr, nullptr) == SQLITE_OK &&
+                  sqlite3_exec(conn, "SELECT 1 FROM recipes LIMIT 1;", nullptr, nullptr, nullptr) == SQLITE_OK; // Opens the snapshot
+        const char *selectSQL = "SELECT name, ingredients, category, instructions, favorite FROM live_recipes WHERE id BETWEEN ? AND ? ORDER BY id;";
+        ok = ok && sqlite3_prepare_v2(conn, selectSQL, -1, &select, nullptr) == SQLITE_OK;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++started;
+            failed = failed || !ok;
+            changed.notify_all();
+        }
+
+        while (ok) {
+            size_t r;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return failed || nextRange >= rangeCount || nextRange < written + maxAhead; });
+                if (failed || nextRange >= rangeCount) {
+                    break;
+                }
+                r = nextRange++;
+            }
+
+            Range &range = ranges[r];
+            int64_t first = minId + static_cast<int64_t>(r) * rangeSize;
+            sqlite3_bind_int64(select, 1, first);
+            sqlite3_bind_int64(select, 2, first + rangeSize - 1);
+            int rc;
+            while ((rc = sqlite3_step(select)) == SQLITE_ROW) {
+                range.bytes += RecipeWriter::encode(format, recipeToJson(recipeFromRow(select)));
+                range.ends.push_back(range.bytes.size());
+            }
+            sqlite3_reset(select);
+            ok = rc == SQLITE_DONE;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            range.done = ok;
+            failed = failed || !ok;
+            changed.notify_all();
+        }
+
+        sqlite3_finalize(select);
+        if (conn) {
+            sqlite3_exec(conn, "COMMIT;", nullptr, nullptr, nullptr);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < std::min(threads, rangeCount); ++t) {
+        workers.emplace_back(worker);
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return started == workers.size(); });
+    }
+    writeLock.unlock(); // Every snapshot is open; writers may continue
+
+    RecipeWriter writer(outFile, format);
+    writer.begin(count);
+    for (size_t r = 0; r < rangeCount; ++r) {
+        Range range;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return failed || ranges[r].done; });
+            if (failed) {
+                break;
+            }
+            range = std::move(ranges[r]);
+        }
+
+        size_t begin = 0;
+        for (size_t end : range.ends) {
+            writer.writeEncoded(range.bytes.data() + begin, end - begin);
+            begin = end;
+        }
 
-// Constructor: Initialize the SQLite Database
-RecipeManager::RecipeManager() {
-    if (sqlite3_open("recipes.db", &db)) {
-        std::cerr << "Failed to open database: " << sqlite3_errmsg(db) << std::endl;
-        db = nullptr;
-        return;
+        std::lock_guard<std::mutex> lock(mutex);
+        ++written;
+        changed.notify_all();
     }
 
-    const char *createTableSQL = R"(
-        CREATE TABLE IF NOT EXISTS recipes (
-            id INTEGER PRIMARY KEY AUTOINCREMENT,
-            name TEXT NOT NULL,
-            ingredients TEXT NOT NULL,
-            category TEXT NOT NULL,
-            instructions TEXT NOT NULL DEFAULT '',
-            favorite INTEGER DEFAULT 0
-        );
-    )";
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (written < rangeCount) {
+            failed = true; // Stop workers waiting for room
+        }
+        changed.notify_all();
+    }
+    for (auto &thread : workers) {
+        thread.join();
+    }
 
-    char *errMsg = nullptr;
-    if (sqlite3_exec(db, createTableSQL, nullptr, nullptr, &errMsg) != SQLITE_OK) {
-        std::cerr << "Failed to create table: " << errMsg << std::endl;
-        sqlite3_free(errMsg);
+    if (failed) {
+        std::cerr << "Failed to retrieve recipes: parallel export stopped" << std::endl;
+        return false;
     }
+    return writer.finish();
 }
 
-// Destructor: Close the SQLite Database
-RecipeManager::~RecipeManager() {
-    if (db) {
-        sqlite3_close(db);
-    }
+// Import Recipes (format chosen by file extension, JSON by default)
+bool RecipeManager::importRecipes(const std::string &filePath) {
+    return importRecipes(filePath, recipeFormatForPath(filePath));
 }
 
-// Add a Recipe
-bool RecipeManager::addRecipe(const std::string &name, const std::vector<std::string> &ingredients, const std::string &category, const std::string &instructions) {
-    std::ostringstream oss;
-    for (size_t i = 0; i < ingredients.size(); ++i) {
-        oss << ingredients[i];
-        if (i < ingredients.size() - 1) {
-            oss << ",";
+// Helper Function: Position an NDJSON import file at the first line
+// beginning at or after fromOffset; returns that line's offset
+static uint64_t seekImportStart(std::ifstream &inFile, uint64_t fromOffset) {
+    uint64_t textStart = fromOffset;
+    if (fromOffset > 0) {
+        // Resume at a line boundary: skip the rest of a line cut by the offset
+        char previous = '\n';
+        inFile.seekg(static_cast<std::streamoff>(fromOffset - 1));
+        inFile.get(previous);
+        if (previous != '\n') {
+            std::string partial;
+            std::getline(inFile, partial);
+            textStart += partial.size() + (inFile.eof() ? 0 : 1);
         }
+        inFile.clear();
+        inFile.seekg(static_cast<std::streamoff>(textStart));
     }
-    std::string ingredientsStr = oss.str();
+    return textStart;
+}
 
-    const char *insertSQL = "INSERT INTO recipes (name, ingredients, category, instructions) VALUES (?, ?, ?, ?);";
-    sqlite3_stmt *stmt;
-    if (sqlite3_prepare_v2(db, insertSQL, -1, &stmt, nullptr) == SQLITE_OK) {
-        sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 2, ingredientsStr.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 3, category.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(stmt, 4, instructions.c_str(), -1, SQLITE_STATIC);
+// Helper Function: Pass every recipe of an import file to consumer. JSON and
+// NDJSON are read in bounded windows from the current position and parsed on
+// the worker pool; the binary formats stream one recipe at a time. endOffset
+// is set to where a JSON or NDJSON read stopped.
+static bool readImportFile(std::ifstream &inFile, RecipeFormat format, const ImportPipeline::Options &options,
+                           const ImportPipeline::Consumer &consumer, uint64_t *endOffset = nullptr) {
+    if (format == RecipeFormat::Json || format == RecipeFormat::Ndjson) {
+        ImportPipeline::Layout layout = format == RecipeFormat::Ndjson ? ImportPipeline::Layout::Lines : ImportPipeline::Layout::Array;
+        return ImportPipeline(options).run(inFile, layout, consumer, endOffset);
+    }
 
-        if (sqlite3_step(stmt) == SQLITE_DONE) {
-            sqlite3_finalize(stmt);
-            return true;
-        } else {
-            std::cerr << "Failed to add recipe: " << sqlite3_errmsg(db) << std::endl;
+    std::string error;
+    bool stopped = false;
+    bool parsed = readRecipes(inFile, format, [&](nlohmann::json &&recipeJson) {
+        PreparedRecipe prepared;
+        if (!prepareRecipe(recipeJson, prepared, error)) {
+            return false;
         }
+        stopped = !consumer(std::move(prepared));
+        return !stopped;
+    });
+    if (!parsed && !stopped) {
+        std::cerr << "Failed to parse import file" << (error.empty() ? "" : ": " + error) << std::endl;
+    }
+    return parsed;
+}
 
+// Helper Function: name_key -> content_hash of every stored recipe, so an
+// import can skip unchanged recipes without any SQL
+static std::unordered_map<std::string, int64_t> loadStoredHashes(sqlite3 *db) {
+    std::unordered_map<std::string, int64_t> storedHashes;
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "SELECT name_key, content_hash FROM live_recipes;", -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            storedHashes.emplace(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)), sqlite3_column_int64(stmt, 1));
+        }
         sqlite3_finalize(stmt);
-    } else {
-        std::cerr << "Failed to prepare insert statement: " << sqlite3_errmsg(db) << std::endl;
     }
-    return false;
+    return storedHashes;
 }
 
-// API Integration: Helper function for HTTP requests
-static size_t WriteCallback(void *contents, size_t size, size_t nmemb, void *userp) {
-    ((std::string *)userp)->append((char *)contents, size * nmemb);
-    return size * nmemb;
+// Import Recipes (re-importing the same file changes nothing)
+bool RecipeManager::importRecipes(const std::string &filePath, RecipeFormat format) {
+    return importRecipes(filePath, format, 0);
 }
 
-// API Integration: Search recipes by ingredient
-std::vector<Recipe> RecipeManager::searchByIngredient(const std::string &ingredient) {
-    std::vector<Recipe> recipes;
-    std::string readBuffer;
-
-    CURL *curl = curl_easy_init();
-    if (curl) {
-        std::string url = "https://www.themealdb.com/api/json/v1/1/filter.php?i=" + ingredient;
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
-        curl_easy_perform(curl);
-        curl_easy_cleanup(curl);
-    }
-
-    // Parse JSON response
-    nlohmann::json jsonData = nlohmann::json::parse(readBuffer, nullptr, false);
-    if (!jsonData.is_discarded() && jsonData["meals"].is_array()) {
-        for (const auto &meal : jsonData["meals"]) {
-            Recipe recipe;
-            recipe.id = std::stoi(meal["idMeal"].get<std::string>());
-            recipe.name = meal["strMeal"].get<std::string>();
-            recipes.push_back(recipe);
-        }
+// Import Recipes starting at a byte offset. NDJSON starts at the first line
+// beginning at or after fromOffset and stops before an unfinished last line,
+// so a file that is still being appended to can be read again from endOffset.
+bool RecipeManager::importRecipes(const std::string &filePath, RecipeFormat format, uint64_t fromOffset, uint64_t *endOffset) {
+    std::ifstream inFile(filePath, std::ios::binary);
+    if (!inFile) {
+        std::cerr << "Failed to open file for import." << std::endl;
+        return false;
+    }
+    if (fromOffset > 0 && format != RecipeFormat::Ndjson) {
+        std::cerr << "Failed to import: only NDJSON files can be read from an offset." << std::endl;
+        return false;
     }
 
-    return recipes;
-}
+    uint64_t textStart = seekImportStart(inFile, fromOffset);
 
-// API Integration: Fetch recipe instructions by ID
-std::string RecipeManager::getRecipeInstructions(int recipeID) {
-    std::string readBuffer;
+    std::lock_guard<std::recursive_mutex> writeLock(writeMutex);
+    ConnectionPool::Lease db = connection();
+    WriteScope scope(db, "import_recipes");
+    if (!scope.ok()) {
+        return false;
+    }
 
-    CURL *curl = curl_easy_init();
-    if (curl) {
-        std::string url = "https://www.themealdb.com/api/json/v1/1/lookup.php?i=" + std::to_string(recipeID);
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
-        curl_easy_perform(curl);
-        curl_easy_cleanup(curl);
+    // A resumed read is usually a short tail, where loading every hash costs more
+    std::unordered_map<std::string, int64_t> storedHashes;
+    if (fromOffset == 0) {
+        storedHashes = loadStoredHashes(db);
     }
 
-    // Parse JSON response
-    nlohmann::json jsonData = nlohmann::json::parse(readBuffer, nullptr, false);
-    if (!jsonData.is_discarded() && jsonData["meals"].is_array()) {
-        return jsonData["meals"][0]["strInstructions"].get<std::string>();
+    sqlite3_stmt *upsert = prepareUpsert(db);
+    if (!upsert) {
+        return false;
     }
 
-    return "No instructions found.";
-}
+    // Runs on this thread only: the transaction belongs to this connection
+    auto write = [&](PreparedRecipe &&prepared) {
+        auto stored = storedHashes.find(prepared.nameKey);
+        if (stored != storedHashes.end() && stored->second == prepared.hash) {
+            return true;
+        }
+        return upsertRecipeRow(db, upsert, prepared) != UpsertResult::Failed;
+    };
 
-// List All Recipes
-std::vector<Recipe> RecipeManager::listAllRecipes() const {
-    std::vector<Recipe> recipes;
+    ImportPipeline::Options options;
+    options.threads = importThreads;
+    options.firstByte = textStart;
+    uint64_t readTo = textStart;
+    bool parsed = readImportFile(inFile, format, options, write, &readTo);
+    sqlite3_finalize(upsert);
 
-    const char *selectSQL = "SELECT name, ingredients, category, instructions, favorite FROM recipes;";
-    sqlite3_stmt *stmt;
+    if (!parsed || !scope.commit()) {
+        return false; // scope rolls back
+    }
+    if (endOffset) {
+        *endOffset = readTo;
+    }
+    return true;
+}
 
-    if (sqlite3_prepare_v2(db, selectSQL, -1, &stmt, nullptr) == SQLITE_OK) {
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            Recipe recipe;
-            recipe.name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
-            std::string ingredientsStr = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
-            recipe.category = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2));
-            recipe.instructions = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3));
-            recipe.isFavorite = sqlite3_column_int(stmt, 4);
+// Helper Function: Identify an import file by its first 64 KB, so a
+// checkpoint is not applied to a different file at the same path
+static int64_t importFingerprint(const std::string &filePath) {
+    std::ifstream inFile(filePath, std::ios::binary);
+    std::string head(64 * 1024, '\0');
+    inFile.read(&head[0], head.size());
+    head.resize(static_cast<size_t>(inFile.gcount()));
+    return recipeContentHash(head, "", "", "", false);
+}
 
-            // Parse ingredients into a vector
-            std::istringstream iss(ingredientsStr);
-            std::string ingredient;
-            while (std::getline(iss, ingredient, ',')) {
-                recipe.ingredients.push_back(trim(ingredient));
-            }
+// Import Recipes in batches of batchSize, committing the position reached
+// with each batch. After a crash or failure the same call continues after
+// the last committed batch; the checkpoint is removed once the file is done.
+bool RecipeManager::importRecipesCheckpointed(const std::string &filePath, size_t batchSize) {
+    RecipeFormat format = recipeFormatForPath(filePath);
+    std::ifstream inFile(filePath, std::ios::binary);
+    if (!inFile) {
+        std::cerr << "Failed to open file for import." << std::endl;
+        return false;
+    }
+    int64_t fingerprint = importFingerprint(filePath);
+    batchSize = std::max<size_t>(batchSize, 1);
+
+    std::lock_guard<std::recursive_mutex> writeLock(writeMutex);
+    ConnectionPool::Lease db = connection();
+    if (!db) {
+        return false;
+    }
+    if (!sqlite3_get_autocommit(db)) {
+        std::cerr << "Failed to import: a checkpointed import commits on its own and can't run inside a batch." << std::endl;
+        return false;
+    }
 
-            recipes.push_back(recipe);
+    // Where the last run stopped: byte offset for JSON and NDJSON, recipe
+    // count for the binary formats
+    uint64_t resumeOffset = 0;
+    uint64_t resumeRecords = 0;
+    int64_t batchSeq = 0;
+    sqlite3_stmt *stmt;
+    const char *checkpointSQL = "SELECT byte_offset, records, batch_seq FROM import_checkpoints WHERE path = ? AND fingerprint = ?;";
+    if (sqlite3_prepare_v2(db, checkpointSQL, -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, filePath.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 2, fingerprint);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            resumeOffset = static_cast<uint64_t>(sqlite3_column_int64(stmt, 0));
+            resumeRecords = static_cast<uint64_t>(sqlite3_column_int64(stmt, 1));
+            batchSeq = sqlite3_column_int64(stmt, 2);
         }
         sqlite3_finalize(stmt);
-    } else {
-        std::cerr << "Failed to retrieve recipes: " << sqlite3_errmsg(db) << std::endl;
     }
 
-    return recipes;
-}
+    bool textFormat = format == RecipeFormat::Json || format == RecipeFormat::Ndjson;
+    ImportPipeline::Options options;
+    options.threads = importThreads;
+    if (format == RecipeFormat::Ndjson) {
+        options.firstByte = seekImportStart(inFile, resumeOffset);
+    } else if (format == RecipeFormat::Json && resumeOffset > 0) {
+        // The offset is where the last imported element ends: read on from there
+        inFile.seekg(static_cast<std::streamoff>(resumeOffset));
+        options.firstByte = resumeOffset;
+        options.afterElement = true;
+    }
 
-// Updated displayRecipeUI function
-void RecipeManager::displayRecipeUI(const Recipe& recipe) {
-    GtkApplication* app = gtk_application_new("com.example.recipe", G_APPLICATION_DEFAULT_FLAGS);
+    sqlite3_stmt *upsert = prepareUpsert(db);
+    sqlite3_stmt *saveCheckpoint = nullptr;
+    const char *saveSQL = R"(
+        INSERT OR REPLACE INTO import_checkpoints (path, fingerprint, byte_offset, records, batch_seq)
+        VALUES (?, ?, ?, ?, ?);
+    )";
+    if (!upsert || sqlite3_prepare_v2(db, saveSQL, -1, &saveCheckpoint, nullptr) != SQLITE_OK ||
+        sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to begin checkpointed import: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_finalize(upsert);
+        sqlite3_finalize(saveCheckpoint);
+        return false;
+    }
 
-    // Replace the lambda with a standard static function
-    g_signal_connect(app, "activate", G_CALLBACK(on_activate), (gpointer)&recipe);
+    std::unordered_map<std::string, int64_t> storedHashes = loadStoredHashes(db);
+    uint64_t records = textFormat ? resumeRecords : 0;
+    uint64_t position = resumeOffset;
+    size_t pending = 0;
 
-    g_application_run(G_APPLICATION(app), 0, nullptr);
-    g_object_unref(app);
-}
+    // Store the position reached in the batch's own transaction, then start the next
+    auto commitBatch = [&] {
+        sqlite3_bind_text(saveCheckpoint, 1, filePath.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(saveCheckpoint, 2, fingerprint);
+        sqlite3_bind_int64(saveCheckpoint, 3, static_cast<int64_t>(position));
+        sqlite3_bind_int64(saveCheckpoint, 4, static_cast<int64_t>(records));
+        sqlite3_bind_int64(saveCheckpoint, 5, batchSeq + 1);
+        bool saved = sqlite3_step(saveCheckpoint) == SQLITE_DONE &&
+                     sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) == SQLITE_OK;
+        sqlite3_reset(saveCheckpoint);
+        if (!saved) {
+            std::cerr << "Failed to commit import batch: " << sqlite3_errmsg(db) << std::endl;
+            return false;
+        }
+        ++batchSeq;
+        pending = 0;
+        return sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) == SQLITE_OK;
+    };
 
-// Toggle Recipe as Favorite
-bool RecipeManager::toggleFavorite(const std::string &name) {
-    const char *updateSQL = R"(
-        UPDATE recipes
-        SET favorite = NOT favorite
-        WHERE name = ?;
-    )";
+    bool parsed = readImportFile(inFile, format, options, [&](PreparedRecipe &&prepared) {
+        if (!textFormat && records < resumeRecords) {
+            ++records; // Already imported by an earlier run
+            return true;
+        }
+        auto stored = storedHashes.find(prepared.nameKey);
+        if ((stored == storedHashes.end() || stored->second != prepared.hash) &&
+            upsertRecipeRow(db, upsert, prepared) == UpsertResult::Failed) {
+            return false;
+        }
+        ++records;
+        position = prepared.sourceEnd;
+        return ++pending < batchSize || commitBatch();
+    });
+    sqlite3_finalize(upsert);
+    sqlite3_finalize(saveCheckpoint);
+
+    // The last batch also drops the checkpoint: the file is done
+    bool finished = false;
+    if (parsed && !sqlite3_get_autocommit(db)) {
+        sqlite3_stmt *remove;
+        if (sqlite3_prepare_v2(db, "DELETE FROM import_checkpoints WHERE path = ?;", -1, &remove, nullptr) == SQLITE_OK) {
+            sqlite3_bind_text(remove, 1, filePath.c_str(), -1, SQLITE_STATIC);
+            finished = sqlite3_step(remove) == SQLITE_DONE;
+            sqlite3_finalize(remove);
+        }
+        finished = finished && sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) == SQLITE_OK;
+    }
+    if (!finished) {
+        std::cerr << "Failed to finish import; " << batchSeq << " batches are kept and the next run resumes after them." << std::endl;
+        if (!sqlite3_get_autocommit(db)) {
+            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr); // Only the unfinished batch
+        }
+        return false;
+    }
+    return true;
+}
 
+// Delete a Recipe by Name
+bool RecipeManager::deleteRecipe(const std::string &name) {
+    std::lock_guard<std::recursive_mutex> writeLock(writeMutex);
+    ConnectionPool::Lease db = connection();
+    const char *deleteSQL = "DELETE FROM recipes WHERE generation = (SELECT generation FROM recipe_meta) AND name_key = recipe_name_key(?);";
     sqlite3_stmt *stmt;
-    if (sqlite3_prepare_v2(db, updateSQL, -1, &stmt, nullptr) == SQLITE_OK) {
+
+    if (sqlite3_prepare_v2(db, deleteSQL, -1, &stmt, nullptr) == SQLITE_OK) {
         sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
 
         if (sqlite3_step(stmt) == SQLITE_DONE) {
             sqlite3_finalize(stmt);
             return true;
         } else {
-            std::cerr << "Failed to update favorite status: " << sqlite3_errmsg(db) << std::endl;
+            std::cerr << "Failed to delete recipe: " << sqlite3_errmsg(db) << std::endl;
         }
 
         sqlite3_finalize(stmt);
     } else {
-        std::cerr << "Failed to prepare update statement: " << sqlite3_errmsg(db) << std::endl;
+        std::cerr << "Failed to prepare delete statement: " << sqlite3_errmsg(db) << std::endl;
     }
     return false;
 }
 
-// List Favorite Recipes
-std::string RecipeManager::listFavoriteRecipes() const {
-    std::string favoriteList;
-    const char *selectSQL = "SELECT name, category FROM recipes WHERE favorite = 1;";
-    sqlite3_stmt *stmt;
-
-    if (sqlite3_prepare_v2(db, selectSQL, -1, &stmt, nullptr) == SQLITE_OK) {
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            std::string name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
-            std::string category = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
-            favoriteList += name + " (" + category + ")\n";
-        }
-        sqlite3_finalize(stmt);
-    } else {
-        std::cerr << "Failed to retrieve favorite recipes: " << sqlite3_errmsg(db) << std::endl;
+// Helper Function: Start a new, empty generation and log the clear
+static bool clearGeneration(sqlite3 *db) {
+    WriteScope scope(db, "clear_recipes");
+    const char *clearSQL = R"(
+        UPDATE recipe_meta SET undo_generation = generation, generation = generation + 1,
+                               cleared_at = CAST(strftime('%s', 'now') AS INTEGER);
+        INSERT INTO recipe_changes (recipe_id, name_key, op) VALUES (0, '', 'clear');
+    )";
+    char *errMsg = nullptr;
+    if (!scope.ok() || sqlite3_exec(db, clearSQL, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::cerr << "Failed to clear database: " << (errMsg ? errMsg : sqlite3_errmsg(db)) << std::endl;
+        sqlite3_free(errMsg);
+        return false;
     }
-
-    return favoriteList;
+    return scope.commit();
 }
 
-// Filter Recipes by Category
-std::string RecipeManager::filterRecipesByCategory(const std::string &category) const {
-    std::string filteredList;
-    const char *selectSQL = "SELECT name, ingredients FROM recipes WHERE category = ?;";
+// Export Changes since a Sequence Number to JSON. Each changed recipe appears
+// once with its current state (or as a delete), ordered by its last change.
+// After a clear, only the clear and the changes made since are written.
+bool RecipeManager::exportChangesSince(int64_t sinceSeq, const std::string &filePath, int64_t *untilSeq) const {
+    ConnectionPool::Lease db = connection();
+    ReadScope snapshot(db); // The clear and the changes after it come from the same state
+
+    nlohmann::json changes = nlohmann::json::array();
+    int64_t lastSeq = sinceSeq;
     sqlite3_stmt *stmt;
+    const char *clearSQL = "SELECT MAX(seq) FROM recipe_changes WHERE op = 'clear' AND seq > ?;";
+    if (sqlite3_prepare_v2(db, clearSQL, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to retrieve changes: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    sqlite3_bind_int64(stmt, 1, sinceSeq);
+    if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt, 0) != SQLITE_NULL) {
+        lastSeq = sqlite3_column_int64(stmt, 0);
+        changes.push_back({{"seq", lastSeq}, {"op", "clear"}});
+    }
+    sqlite3_finalize(stmt);
 
-    if (sqlite3_prepare_v2(db, selectSQL, -1, &stmt, nullptr) == SQLITE_OK) {
-        sqlite3_bind_text(stmt, 1, category.c_str(), -1, SQLITE_STATIC);
+    const char *changesSQL = R"(
+        SELECT c.seq, c.name_key, r.name, r.ingredients, r.category, r.instructions, r.favorite
+        FROM (SELECT name_key, MAX(seq) AS seq FROM recipe_changes INDEXED BY idx_recipe_changes_seq
+              WHERE seq > ? AND op <> 'clear' GROUP BY name_key) AS c
+        LEFT JOIN live_recipes AS r ON r.name_key = c.name_key
+        ORDER BY c.seq;
+    )";
+    if (sqlite3_prepare_v2(db, changesSQL, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to retrieve changes: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    sqlite3_bind_int64(stmt, 1, lastSeq);
 
-        while (sqlite3_step(stmt) == SQLITE_ROW) {
-            std::string name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
-            std::string ingredients = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
-            filteredList += name + ": " + ingredients + "\n";
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        nlohmann::json change;
+        lastSeq = sqlite3_column_int64(stmt, 0);
+        change["seq"] = lastSeq;
+        if (sqlite3_column_type(stmt, 2) == SQLITE_NULL) {
+            change["op"] = "delete";
+            change["name_key"] = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 1));
+        } else {
+            Recipe recipe;
+            recipe.name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 2));
+            recipe.ingredients = splitIngredients(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3)));
+            recipe.category = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 4));
+            recipe.instructions = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 5));
+            recipe.isFavorite = sqlite3_column_int(stmt, 6) != 0;
+
+            change["op"] = "upsert";
+            change["recipe"] = recipeToJson(recipe);
         }
-        sqlite3_finalize(stmt);
-    } else {
-        std::cerr << "Failed to filter recipes: " << sqlite3_errmsg(db) << std::endl;
+        changes.push_back(change);
+    }
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+        std::cerr << "Failed to retrieve changes: " << sqlite3_errmsg(db) << std::endl;
+        return false;
     }
 
-    return filteredList;
-}
-
-// Export Recipes to JSON
-bool RecipeManager::exportRecipes(const std::string &filePath) const {
     std::ofstream outFile(filePath);
     if (!outFile) {
         std::cerr << "Failed to open file for export." << std::endl;
@@ -311,56 +2705,260 @@ bool RecipeManager::exportRecipes(const std::string &filePath) const {
     }
 
     nlohmann::json jsonExport;
-
-    for (const auto &recipe : listAllRecipes()) {
-        nlohmann::json recipeJson;
-        recipeJson["name"] = recipe.name;
-        recipeJson["ingredients"] = recipe.ingredients;
-        recipeJson["category"] = recipe.category;
-        recipeJson["instructions"] = recipe.instructions;
-        recipeJson["favorite"] = recipe.isFavorite;
-
-        jsonExport.push_back(recipeJson);
-    }
-
+    jsonExport["since"] = sinceSeq;
+    jsonExport["until"] = lastSeq;
+    jsonExport["changes"] = changes;
     outFile << jsonExport.dump(4);
     outFile.close();
-    return true;
+
+    if (untilSeq) {
+        *untilSeq = lastSeq;
+    }
+    return static_cast<bool>(outFile);
 }
 
-// Import Recipes from JSON
-bool RecipeManager::importRecipes(const std::string &filePath) {
+// Apply a Change File written by exportChangesSince() in one transaction
+bool RecipeManager::applyChanges(const std::string &filePath, int64_t *untilSeq) {
     std::ifstream inFile(filePath);
     if (!inFile) {
         std::cerr << "Failed to open file for import." << std::endl;
         return false;
     }
 
-    nlohmann::json jsonImport;
-    inFile >> jsonImport;
+    nlohmann::json jsonImport = nlohmann::json::parse(inFile, nullptr, false);
+    if (jsonImport.is_discarded() || !jsonImport.is_object() || !jsonImport["changes"].is_array()) {
+        std::cerr << "Failed to parse change file." << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::recursive_mutex> writeLock(writeMutex);
+    ConnectionPool::Lease db = connection();
+    WriteScope scope(db, "apply_changes");
+    if (!scope.ok()) {
+        return false;
+    }
 
-    for (const auto &recipeJson : jsonImport) {
-        std::string name = recipeJson["name"];
-        std::vector<std::string> ingredients = recipeJson["ingredients"];
-        std::string category = recipeJson["category"];
-        std::string instructions = recipeJson["instructions"];
-        bool isFavorite = recipeJson["favorite"];
+    sqlite3_stmt *upsert = prepareUpsert(db);
+    sqlite3_stmt *remove = nullptr;
+    const char *removeSQL = "DELETE FROM recipes WHERE generation = (SELECT generation FROM recipe_meta) AND name_key = recipe_name_key(?);";
+    if (!upsert || sqlite3_prepare_v2(db, removeSQL, -1, &remove, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to prepare change statements: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_finalize(upsert);
+        return false;
+    }
 
-        addRecipe(name, ingredients, category, instructions);
-        if (isFavorite) {
-            toggleFavorite(name);
+    bool ok = true;
+    bool cleared = false;
+    for (const auto &change : jsonImport["changes"]) {
+        if (change.value("op", "") == "clear") {
+            ok = clearGeneration(db);
+            cleared = true;
+        } else if (change.value("op", "") == "delete") {
+            std::string nameKey = change.value("name_key", "");
+            sqlite3_bind_text(remove, 1, nameKey.c_str(), -1, SQLITE_STATIC);
+            ok = sqlite3_step(remove) == SQLITE_DONE;
+            if (!ok) {
+                std::cerr << "Failed to delete recipe: " << sqlite3_errmsg(db) << std::endl;
+            }
+            sqlite3_reset(remove);
+        } else {
+            PreparedRecipe prepared;
+            std::string error;
+            ok = prepareRecipe(change["recipe"], prepared, error) &&
+                 upsertRecipeRow(db, upsert, prepared) != UpsertResult::Failed;
+            if (!ok && !error.empty()) {
+                std::cerr << "Failed to apply change: " << error << std::endl;
+            }
+        }
+        if (!ok) {
+            break; // scope rolls back
         }
     }
+    sqlite3_finalize(upsert);
+    sqlite3_finalize(remove);
 
+    if (!ok || !scope.commit()) {
+        return false;
+    }
+    if (cleared && maintenance) {
+        maintenance->wake();
+    }
+    if (untilSeq) {
+        *untilSeq = jsonImport.value("until", int64_t(0));
+    }
     return true;
 }
 
-// Clear Database
+// Set the number of threads for exports
+void RecipeManager::setExportThreads(size_t threads) {
+    exportThreads = threads;
+}
+
+// Set the number of parser threads for JSON imports
+void RecipeManager::setImportThreads(size_t threads) {
+    importThreads = threads;
+}
+
+// Clear Database: starts a new, empty generation without touching the
+// stored rows; they are deleted in the background once the undo window ends
 void RecipeManager::clearDatabase() {
-    const char *deleteSQL = "DELETE FROM recipes;";
+    {
+        std::lock_guard<std::recursive_mutex> writeLock(writeMutex);
+        ConnectionPool::Lease db = connection();
+        if (!clearGeneration(db)) {
+            return;
+        }
+    }
+    if (maintenance) {
+        maintenance->wake(); // Reclaims the rows after the undo window, when idle
+    }
+}
+
+// Undo the Last Clear: brings back the cleared recipes, except those whose
+// name has been used again since. Fails once reclamation has started.
+bool RecipeManager::undoClear() {
+    std::lock_guard<std::recursive_mutex> writeLock(writeMutex);
+    ConnectionPool::Lease db = connection();
+    WriteScope scope(db, "undo_clear");
+    if (!scope.ok()) {
+        return false;
+    }
+
+    // Restored rows change only their generation, which the triggers don't
+    // log, so they are logged here as inserts
+    const char *restoreSQL = R"(
+        CREATE TEMP TABLE IF NOT EXISTS restored_recipes (id INTEGER PRIMARY KEY);
+        DELETE FROM temp.restored_recipes;
+        INSERT INTO temp.restored_recipes
+            SELECT r.id FROM recipes AS r, recipe_meta AS m
+            WHERE r.generation = m.undo_generation
+              AND NOT EXISTS (SELECT 1 FROM recipes WHERE generation = m.generation AND name_key = r.name_key);
+        UPDATE recipes SET generation = (SELECT generation FROM recipe_meta)
+            WHERE id IN (SELECT id FROM temp.restored_recipes);
+        INSERT INTO recipe_changes (recipe_id, name_key, op)
+            SELECT id, name_key, 'insert' FROM recipes WHERE id IN (SELECT id FROM temp.restored_recipes) ORDER BY id;
+        UPDATE recipe_meta SET undo_generation = NULL;
+        DELETE FROM temp.restored_recipes;
+    )";
+
+    sqlite3_stmt *stmt;
+    bool undoable = false;
+    if (sqlite3_prepare_v2(db, "SELECT undo_generation IS NOT NULL FROM recipe_meta;", -1, &stmt, nullptr) == SQLITE_OK) {
+        undoable = sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_int(stmt, 0) != 0;
+        sqlite3_finalize(stmt);
+    }
+    if (!undoable) {
+        std::cerr << "Failed to undo clear: there is no clear to undo, or its recipes are already being reclaimed" << std::endl;
+        return false;
+    }
+
+    // Nothing written since the clear: switching back is enough
+    const char *swapSQL = R"(
+        INSERT INTO recipe_changes (recipe_id, name_key, op)
+            SELECT id, name_key, 'insert' FROM recipes WHERE generation = (SELECT undo_generation FROM recipe_meta) ORDER BY id;
+        UPDATE recipe_meta SET generation = undo_generation, undo_generation = NULL;
+    )";
+    bool empty = false;
+    if (sqlite3_prepare_v2(db, "SELECT NOT EXISTS (SELECT 1 FROM live_recipes);", -1, &stmt, nullptr) == SQLITE_OK) {
+        empty = sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_int(stmt, 0) != 0;
+        sqlite3_finalize(stmt);
+    }
+
+    char *errMsg = nullptr;
+    if (sqlite3_exec(db, empty ? swapSQL : restoreSQL, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::cerr << "Failed to undo clear: " << errMsg << std::endl;
+        sqlite3_free(errMsg);
+        return false; // scope rolls back
+    }
+    return scope.commit();
+}
+
+// Set how long a clear can be undone before its rows are reclaimed
+void RecipeManager::setClearUndoWindow(std::chrono::seconds window) {
+    clearUndoWindow = window;
+    ensureOpen();
+    if (maintenance) {
+        maintenance->wake();
+    }
+}
+
+// Change when and for how long background maintenance runs
+void RecipeManager::configureMaintenance(const MaintenanceScheduler::Options &options) {
+    ensureOpen();
+    if (maintenance) {
+        maintenance->setOptions(options);
+    }
+}
+
+// Run all maintenance now on the calling thread, without waiting for idle time
+bool RecipeManager::runMaintenance() {
+    ensureOpen();
+    return maintenance && maintenance->runNow();
+}
+
+// What each maintenance task did last
+std::vector<MaintenanceScheduler::TaskStatus> RecipeManager::maintenanceStatus() const {
+    ensureOpen();
+    return maintenance ? maintenance->status() : std::vector<MaintenanceScheduler::TaskStatus>();
+}
+
+
+// Begin a Batch Transaction: keeps the write lock and this thread's
+// connection until commitTransaction() or rollbackTransaction()
+bool RecipeManager::beginTransaction() {
+    ensureOpen();
+    writeMutex.lock();
+    if (transactionOpen) {
+        writeMutex.unlock();
+        std::cerr << "Failed to begin transaction: a batch is already open" << std::endl;
+        return false;
+    }
+
+    sqlite3 *db = pool ? pool->retain() : nullptr;
+    char *errMsg = nullptr;
+    if (!db || sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::cerr << "Failed to begin transaction: " << (errMsg ? errMsg : "no connection") << std::endl;
+        sqlite3_free(errMsg);
+        if (db) {
+            pool->release();
+        }
+        writeMutex.unlock();
+        return false;
+    }
+    transactionOpen = true;
+    return true;
+}
+
+// Commit a Batch Transaction (on failure the batch stays open for rollback)
+bool RecipeManager::commitTransaction() {
+    std::lock_guard<std::recursive_mutex> writeLock(writeMutex);
+    if (!transactionOpen) {
+        return false;
+    }
+    ConnectionPool::Lease db = connection();
     char *errMsg = nullptr;
-    if (sqlite3_exec(db, deleteSQL, nullptr, nullptr, &errMsg) != SQLITE_OK) {
-        std::cerr << "Failed to clear database: " << errMsg << std::endl;
+    if (sqlite3_exec(db, "COMMIT;", nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::cerr << "Failed to commit transaction: " << errMsg << std::endl;
         sqlite3_free(errMsg);
+        return false;
+    }
+    transactionOpen = false;
+    pool->release();
+    writeMutex.unlock(); // The lock taken in beginTransaction()
+    return true;
+}
+
+// Roll Back a Batch Transaction
+void RecipeManager::rollbackTransaction() {
+    std::lock_guard<std::recursive_mutex> writeLock(writeMutex);
+    if (!transactionOpen) {
+        return;
+    }
+    ConnectionPool::Lease db = connection();
+    if (!sqlite3_get_autocommit(db)) {
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
     }
+    transactionOpen = false;
+    pool->release();
+    writeMutex.unlock(); // The lock taken in beginTransaction()
 }
@@ -1,50 +1,246 @@
 #ifndef RECIPEMANAGER_H
 #define RECIPEMANAGER_H
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 #include <sqlite3.h>
+#include "ConnectionPool.h"
+#include "MaintenanceScheduler.h"
+#include "MealDbClient.h"
+#include "RecipeCache.h"
+#include "RecipeFormat.h"
+#include "WriteQueue.h"
 
 // Recipe Structure
 struct Recipe {
-    int id = 0; // ID for API-based recipes
+    int id = 0; // Database ID for saved recipes, TheMealDB ID for API-based ones
     std::string name;
     std::vector<std::string> ingredients;
     std::string category;
     std::string instructions;
     bool isFavorite = false;
+    std::string thumbnailUrl; // strMealThumb for API-based recipes
 };
 
+// Changes for updateRecipe(); fields left unset keep their stored value
+struct RecipePatch {
+    std::optional<std::string> name;
+    std::optional<std::string> category;
+    std::optional<std::string> instructions;
+    std::optional<bool> isFavorite;
+    std::vector<std::string> addIngredients;    // Appended unless already listed
+    std::vector<std::string> removeIngredients; // Matched ignoring case and spacing
+};
+
+// Normalized recipe name used as the unique key (lowercase, single spaces)
+std::string recipeNameKey(const std::string &name);
+
+// Recipes in a TheMealDB {"meals": [...]} response, read without a DOM;
+// none if the body is malformed
+std::vector<Recipe> recipesFromMealJson(std::string_view body);
+
+// Ingredients joined into the single column they are stored in
+std::string joinIngredients(const std::vector<std::string> &ingredients);
+
+// Hash of a recipe's stored content, used to skip unchanged rows on import
+int64_t recipeContentHash(const std::string &name, const std::string &ingredients, const std::string &category, const std::string &instructions, bool favorite);
+
 // RecipeManager Class
+// Safe to share between threads: each call borrows a pooled connection, and
+// writes from this process are serialized before they reach SQLite.
 class RecipeManager {
 public:
-    RecipeManager();  // Constructor to initialize the database
+    // Immediate opens the database in the constructor; Deferred waits for
+    // openInBackground() or the first call that needs the database
+    enum class OpenMode { Immediate, Deferred };
+
+    explicit RecipeManager(const std::string &dbPath = "recipes.db", OpenMode mode = OpenMode::Immediate); // Constructor to initialize the database
     ~RecipeManager(); // Destructor to close the database
 
+    // Open and migrate the database on a worker thread; calls made before it
+    // finishes block until the database is ready
+    void openInBackground();
+
+    // Result of an idempotent write
+    enum class UpsertResult { Written, Unchanged, Failed };
+
     // Recipe Management
+    // Names are unique ignoring case and spacing; addRecipe fails on a duplicate
     bool addRecipe(const std::string &name, const std::vector<std::string> &ingredients, const std::string &category, const std::string &instructions);
+    UpsertResult upsertRecipe(const Recipe &recipe); // Insert, or update the recipe with the same name
+    UpsertResult updateRecipe(int id, const RecipePatch &patch); // Writes only the columns that change
+    int findRecipeId(const std::string &name) const; // Database ID, or 0 if there is no such recipe
+    std::optional<Recipe> getRecipe(int id) const;
+    std::vector<Recipe> getRecipes(const std::vector<int> &ids) const; // Same order; unknown IDs skipped
     std::vector<Recipe> listAllRecipes() const;
     bool toggleFavorite(const std::string &name);
+    bool deleteRecipe(const std::string &name);
     std::string listFavoriteRecipes() const;
 
+    // Group-commit variants: writes from concurrent callers are coalesced into
+    // one transaction per batch window; each future completes after commit.
+    // Don't wait on these while holding a batch transaction on this thread.
+    std::future<bool> addRecipeAsync(const std::string &name, const std::vector<std::string> &ingredients, const std::string &category, const std::string &instructions);
+    std::future<bool> toggleFavoriteAsync(const std::string &name);
+    bool configureWriteQueue(const WriteQueue::Options &options); // Before first async write
+
     // Category and Filtering
     std::string filterRecipesByCategory(const std::string &category) const;
+    std::vector<Recipe> searchLocalByIngredient(const std::string &ingredient) const; // Saved recipes only
+    std::vector<Recipe> searchLocalByName(const std::string &prefix) const; // Names starting with prefix
+
+    // Federated Search: saved recipes (by name prefix and ingredient) and
+    // TheMealDB (by ingredient and by name) at once. The remote requests
+    // start first and run on a worker thread. The saved recipes are
+    // delivered right away on the calling thread, then the remote hits as
+    // each response arrives, from the worker thread. A recipe whose name was
+    // already delivered is left out. Responses after the deadline are dropped,
+    // and nothing is delivered after the manager has been destroyed.
+    enum class SearchSource { Local, Remote };
+    struct SearchOptions {
+        std::chrono::milliseconds deadline{3000}; // For the remote requests
+        bool remote = true;
+    };
+    // finished is set on the last call, which may bring no recipes
+    using SearchCallback = std::function<void(SearchSource source, const std::vector<Recipe> &recipes, bool finished)>;
+    void searchAll(const std::string &query, const SearchOptions &options, SearchCallback onResults) const;
 
-    // Export/Import Recipes
+    // Export/Import Recipes (JSON, or NDJSON/CBOR/MessagePack/BSON by file
+    // extension). NDJSON exports can append to a file, and NDJSON imports can
+    // resume at a byte offset; endOffset is where the next read should start.
+    // A checkpointed import commits every batchSize recipes together with the
+    // position reached, and a rerun after a crash resumes after the last batch.
     bool exportRecipes(const std::string &filePath) const;
+    bool exportRecipes(const std::string &filePath, RecipeFormat format, bool append = false) const;
     bool importRecipes(const std::string &filePath);
+    bool importRecipes(const std::string &filePath, RecipeFormat format);
+    bool importRecipes(const std::string &filePath, RecipeFormat format, uint64_t fromOffset, uint64_t *endOffset = nullptr);
+    bool importRecipesCheckpointed(const std::string &filePath, size_t batchSize = 10000);
+    void setImportThreads(size_t threads); // JSON parser threads; 0 = one per core, 1 = parse inline
+    void setExportThreads(size_t threads); // Serializer threads; 0 = one per core, 1 = single-threaded
+
+    // Delta Sync: every write is logged with an increasing sequence number.
+    // exportChangesSince() writes the recipes changed after sinceSeq and sets
+    // untilSeq to the last sequence included; pass that value next time.
+    // applyChanges() replays such a file and reports the same untilSeq.
+    bool exportChangesSince(int64_t sinceSeq, const std::string &filePath, int64_t *untilSeq = nullptr) const;
+    bool applyChanges(const std::string &filePath, int64_t *untilSeq = nullptr);
 
     // Database Management
+    // clearDatabase() returns at once: the recipes are hidden, then deleted
+    // in the background after the undo window, in short transactions.
+    // undoClear() brings them back until that deletion has started.
     void clearDatabase();
+    bool undoClear();
+    void setClearUndoWindow(std::chrono::seconds window); // Default 60 s
+
+    // Maintenance: reclaiming cleared recipes, ANALYZE after heavy churn,
+    // incremental_vacuum, WAL checkpoints and PRAGMA optimize run on a
+    // background thread once the database has been idle for a while
+    void configureMaintenance(const MaintenanceScheduler::Options &options);
+    bool runMaintenance(); // Everything now, on this thread
+    std::vector<MaintenanceScheduler::TaskStatus> maintenanceStatus() const;
+
+    // Recipes returned by getRecipe()/getRecipes() are kept in a sharded LRU
+    // cache (4096 by default). Writes through this manager evict what they
+    // change; writes from another process are not seen.
+    void setRecipeCacheCapacity(size_t capacity);
+    RecipeCache::Stats recipeCacheStats() const;
 
-    // API Integration
+    // Batch Transactions (used to pipeline many writes into one commit).
+    // begin/commit/rollback must be called from the same thread; other
+    // writers wait until the batch is committed or rolled back.
+    bool beginTransaction();
+    bool commitTransaction();
+    void rollbackTransaction();
+
+    // API Integration. Identical requests in flight at the same time share
+    // one HTTP call, and all requests pass a token-bucket rate limit. Slow
+    // requests are hedged, and while the API is failing the last good
+    // response (or nothing) comes back at once; see MealDbClient.
     std::vector<Recipe> searchByIngredient(const std::string& ingredient); // Search recipes by ingredient
+    // Recipes that use all the ingredients, by ID: one filter request per
+    // distinct ingredient, sent together and intersected. Takes as long as
+    // the slowest request, less if a list comes back empty; none if any
+    // request failed. Lists fetched in the last few minutes are reused.
+    std::vector<Recipe> searchByIngredients(const std::vector<std::string> &ingredients);
     std::string getRecipeInstructions(int recipeID); // Fetch instructions by recipe ID
+    std::optional<Recipe> getRemoteRecipe(int mealId); // Name, category, ingredients and instructions
+    // Write-through: fetch whole TheMealDB recipes (ingredients, category,
+    // instructions) and save them, so later views are read locally. Returns
+    // how many of the IDs are saved now.
+    bool importRemoteRecipe(int mealId);
+    size_t importRemoteRecipes(const std::vector<int> &mealIds);
+
+    // Offline mirror: copy the whole TheMealDB catalog into the local
+    // database (pages by first letter, then by category), with conditional
+    // requests for refreshes. An interrupted sync resumes where it stopped.
+    struct MirrorOptions {
+        size_t threads = 4; // Pages in flight at once
+        std::string letters = "abcdefghijklmnopqrstuvwxyz0123456789";
+        bool categories = true; // Also walk the categories for meals the letters miss
+    };
+    struct MirrorReport {
+        bool complete = false; // Every page applied; the next sync starts a new run
+        size_t pages = 0;      // Pages downloaded and applied
+        size_t unchanged = 0;  // Pages answered 304 Not Modified
+        size_t skipped = 0;    // Pages applied before this run was interrupted
+        size_t failed = 0;     // Pages left for the next sync
+        size_t lookups = 0;    // Meals no letter covers, synced one by one
+        size_t written = 0;    // Recipes added or changed
+    };
+    MirrorReport syncMealDbMirror(const MirrorOptions &options);
+    void configureMealDb(const MealDbClient::Options &options);
+    MealDbClient::Stats mealDbStats() const;
 
-    void displayRecipeUI(const Recipe& recipe);
+    void displayRecipeUI(const Recipe& recipe); // Defined in GUI.cpp
 
 private:
-    sqlite3 *db; // SQLite database connection
+    void ensureOpen() const; // Open the database on first use
+    void openDatabase() const;
+    ConnectionPool::Lease connection() const; // Borrow a connection for this call
+    std::future<bool> submitWrite(WriteQueue::Operation operation); // Group-commit queue, started on first use
+    bool exportRecipesParallel(sqlite3 *db, std::unique_lock<std::recursive_mutex> &writeLock, std::ofstream &outFile, RecipeFormat format, size_t threads) const;
+
+    std::string dbPath;
+    mutable RecipeCache recipeCache; // Hooked into every connection, so declared before them
+    mutable std::unique_ptr<ConnectionPool> pool; // SQLite database connections
+    mutable std::once_flag openFlag;
+    std::thread openThread;
+
+    mutable std::recursive_mutex writeMutex; // Held for each write, or for a whole batch
+    bool transactionOpen = false;            // Guarded by writeMutex
+
+    std::mutex writeQueueMutex;
+    WriteQueue::Options writeQueueOptions;
+    std::unique_ptr<WriteQueue> writeQueue;
+
+    std::atomic<size_t> importThreads{0};
+    std::atomic<size_t> exportThreads{0};
+
+    std::atomic<std::chrono::seconds> clearUndoWindow{std::chrono::seconds(60)};
+    mutable std::unique_ptr<MaintenanceScheduler> maintenance; // Started by openDatabase()
+    std::unique_ptr<MealDbClient> mealDb;
+
+    // Held shared by searchAll() workers while they deliver results, and
+    // exclusively by the destructor, which clears alive
+    struct SearchLifeline {
+        std::shared_mutex mutex;
+        bool alive = true;
+    };
+    std::shared_ptr<SearchLifeline> searchLifeline = std::make_shared<SearchLifeline>();
 };
 
 #endif // RECIPEMANAGER_H
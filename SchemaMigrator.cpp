@@ -0,0 +1,71 @@
+#include "SchemaMigrator.h"
+#include <iostream>
+
+void SchemaMigrator::add(int version, const std::string &description, Step step) {
+    if (version != latestVersion() + 1) {
+        std::cerr << "Failed to register migration " << version << " (" << description << "): expected version "
+                  << latestVersion() + 1 << std::endl;
+        return;
+    }
+    migrations.push_back(Migration{version, description, std::move(step)});
+}
+
+SchemaMigrator::Step SchemaMigrator::sql(const std::string &script) {
+    return [script](sqlite3 *db) {
+        return sqlite3_exec(db, script.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK;
+    };
+}
+
+int SchemaMigrator::latestVersion() const {
+    return migrations.empty() ? 0 : migrations.back().version;
+}
+
+int SchemaMigrator::version(sqlite3 *db) {
+    sqlite3_stmt *stmt;
+    int value = 0;
+    if (sqlite3_prepare_v2(db, "PRAGMA user_version;", -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            value = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    }
+    return value;
+}
+
+bool SchemaMigrator::migrate(sqlite3 *db) const {
+    int current = version(db);
+    if (current > latestVersion()) {
+        std::cerr << "Failed to migrate the database: schema version " << current
+                  << " is newer than this build (" << latestVersion() << ")" << std::endl;
+        return false;
+    }
+
+    for (const Migration &migration : migrations) {
+        if (migration.version <= current) {
+            continue;
+        }
+        if (sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            std::cerr << "Failed to begin migration " << migration.version << ": " << sqlite3_errmsg(db) << std::endl;
+            return false;
+        }
+
+        // Another process may have migrated while this one waited for the lock
+        current = version(db);
+        if (migration.version <= current) {
+            sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+            continue;
+        }
+
+        std::string bump = "PRAGMA user_version = " + std::to_string(migration.version) + ";";
+        if (!migration.step(db) ||
+            sqlite3_exec(db, bump.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK ||
+            sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            std::cerr << "Failed to migrate the database to version " << migration.version << " ("
+                      << migration.description << "): " << sqlite3_errmsg(db) << std::endl;
+            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            return false;
+        }
+        current = migration.version;
+    }
+    return true;
+}
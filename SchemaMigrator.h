@@ -0,0 +1,46 @@
+#ifndef SCHEMAMIGRATOR_H
+#define SCHEMAMIGRATOR_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <sqlite3.h>
+
+// Versioned schema changes, tracked in PRAGMA user_version.
+// Each step runs in its own IMMEDIATE transaction together with the version
+// bump, so a crash leaves the database at the last finished step and the
+// next open carries on from there. Steps must stay quick: a change that has
+// to rewrite every row adds the new layout in its step and moves the rows
+// with a background task in short chunks, while reads accept both layouts.
+// Databases from before versioning report version 0, so the early steps
+// check for what an older build may already have created.
+class SchemaMigrator {
+public:
+    // Brings the schema from the previous version to this one. Runs inside
+    // the step's transaction; return false to roll it back.
+    using Step = std::function<bool(sqlite3 *db)>;
+
+    // Register the step for a version; versions are 1, 2, 3, ... in order
+    void add(int version, const std::string &description, Step step);
+
+    // Step that runs a fixed SQL script
+    static Step sql(const std::string &script);
+
+    int latestVersion() const;
+    static int version(sqlite3 *db); // The database's PRAGMA user_version
+
+    // Apply every step the database hasn't had yet. Returns false if a step
+    // failed or the database was written by a newer build.
+    bool migrate(sqlite3 *db) const;
+
+private:
+    struct Migration {
+        int version;
+        std::string description;
+        Step step;
+    };
+
+    std::vector<Migration> migrations;
+};
+
+#endif // SCHEMAMIGRATOR_H
@@ -0,0 +1,117 @@
+#include "StartupProfiler.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Checkpoint {
+    std::string label;
+    Clock::time_point when;
+};
+
+struct Timeline {
+    std::mutex mutex;
+    Clock::time_point epoch = Clock::now();
+    std::vector<Checkpoint> checkpoints;
+    double execMillis = -1; // exec() to first checkpoint, if the OS reports it
+    bool reported = false;
+};
+
+Timeline &timeline() {
+    static Timeline instance;
+    return instance;
+}
+
+#ifdef __linux__
+// Milliseconds between exec() and now, from the kernel's process start time
+double millisSinceExec() {
+    FILE *stat = std::fopen("/proc/self/stat", "r");
+    if (!stat) {
+        return -1;
+    }
+    char buffer[1024];
+    size_t length = std::fread(buffer, 1, sizeof(buffer) - 1, stat);
+    std::fclose(stat);
+    buffer[length] = '\0';
+
+    // Field 22 (starttime) counts from the ')' that closes the command name
+    const char *cursor = std::strrchr(buffer, ')');
+    if (!cursor) {
+        return -1;
+    }
+    for (int field = 2; field < 22 && cursor; ++field) {
+        cursor = std::strchr(cursor + 1, ' ');
+    }
+    if (!cursor) {
+        return -1;
+    }
+    double startTicks = std::strtod(cursor + 1, nullptr);
+
+    timespec boot{};
+    clock_gettime(CLOCK_BOOTTIME, &boot);
+    double nowMillis = boot.tv_sec * 1000.0 + boot.tv_nsec / 1e6;
+    return nowMillis - startTicks * 1000.0 / sysconf(_SC_CLK_TCK);
+}
+#endif
+
+} // namespace
+
+namespace StartupProfiler {
+
+bool enabled() {
+    static const bool on = [] {
+        const char *value = std::getenv("RECIPE_PROFILE_STARTUP");
+        return value && *value && std::strcmp(value, "0") != 0;
+    }();
+    return on;
+}
+
+void mark(const char *label) {
+    if (!enabled()) {
+        return;
+    }
+    Timeline &t = timeline();
+    std::lock_guard<std::mutex> lock(t.mutex);
+#ifdef __linux__
+    if (t.checkpoints.empty()) {
+        t.execMillis = millisSinceExec();
+    }
+#endif
+    t.checkpoints.push_back({label, Clock::now()});
+}
+
+void report() {
+    if (!enabled()) {
+        return;
+    }
+    Timeline &t = timeline();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    if (t.reported) {
+        return;
+    }
+    t.reported = true;
+
+    if (t.execMillis >= 0) {
+        std::fprintf(stderr, "[startup] exec to first checkpoint: ~%.0f ms (clock tick resolution)\n", t.execMillis);
+    }
+    Clock::time_point previous = t.epoch;
+    for (const auto &checkpoint : t.checkpoints) {
+        double total = std::chrono::duration<double, std::milli>(checkpoint.when - t.epoch).count();
+        double delta = std::chrono::duration<double, std::milli>(checkpoint.when - previous).count();
+        std::fprintf(stderr, "[startup] %9.3f ms (+%8.3f) %s\n", total, delta, checkpoint.label.c_str());
+        previous = checkpoint.when;
+    }
+}
+
+} // namespace StartupProfiler
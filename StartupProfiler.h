@@ -0,0 +1,19 @@
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+// Startup timeline for measuring cold start.
+// Enabled by setting RECIPE_PROFILE_STARTUP=1 in the environment; when
+// disabled every call is a cheap no-op.
+namespace StartupProfiler {
+
+bool enabled();
+
+// Record a named checkpoint (safe to call from any thread)
+void mark(const char *label);
+
+// Print all checkpoints recorded so far to stderr, once
+void report();
+
+} // namespace StartupProfiler
+
+#endif // STARTUPPROFILER_H
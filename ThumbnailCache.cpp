@@ -0,0 +1,338 @@
+#include "ThumbnailCache.h"
+#include <algorithm>
+#include <curl/curl.h>
+#include <glib/gstdio.h>
+#include <iostream>
+
+// Worker result handed back to the main loop
+struct ThumbnailCache::Delivery {
+    ThumbnailCache *cache;
+    std::weak_ptr<bool> alive;
+    std::string url;
+    GdkPixbuf *pixbuf; // Owned reference, or nullptr on failure
+};
+
+static size_t AppendToBuffer(void *contents, size_t size, size_t nmemb, void *userp) {
+    ((std::string *)userp)->append((char *)contents, size * nmemb);
+    return size * nmemb;
+}
+
+// Decode straight to the target size, keeping the aspect ratio
+static void on_size_prepared(GdkPixbufLoader *loader, gint width, gint height, gpointer data) {
+    int target = *static_cast<int *>(data);
+    if (width <= target && height <= target) {
+        return;
+    }
+    if (width >= height) {
+        gdk_pixbuf_loader_set_size(loader, target, std::max(1, height * target / width));
+    } else {
+        gdk_pixbuf_loader_set_size(loader, std::max(1, width * target / height), target);
+    }
+}
+
+ThumbnailCache::ThumbnailCache(int size, size_t memoryLimitBytes, unsigned workerCount, size_t diskLimitBytes, size_t maxQueued)
+    : size(size), memoryLimitBytes(memoryLimitBytes), diskLimitBytes(diskLimitBytes), maxQueued(std::max<size_t>(1, maxQueued)),
+      alive(std::make_shared<bool>(true)) {
+    gchar *dir = g_build_filename(g_get_user_cache_dir(), "recipe_app", "thumbnails", NULL);
+    diskDir = dir;
+    g_free(dir);
+    if (g_mkdir_with_parents(diskDir.c_str(), 0700) != 0) {
+        std::cerr << "Failed to create thumbnail cache directory: " << diskDir << std::endl;
+        diskDir.clear();
+    }
+
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    for (unsigned i = 0; i < std::max(1u, workerCount); ++i) {
+        workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+ThumbnailCache::~ThumbnailCache() {
+    alive.reset();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+        queue.clear();
+    }
+    queueReady.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    for (auto &entry : lru) {
+        g_object_unref(entry.second);
+    }
+}
+
+ThumbnailCache::Ticket ThumbnailCache::request(const std::string &url, Callback callback) {
+    if (url.empty()) {
+        callback(nullptr);
+        return 0;
+    }
+
+    auto hit = lruIndex.find(url);
+    if (hit != lruIndex.end()) {
+        lru.splice(lru.begin(), lru, hit->second);
+        callback(hit->second->second);
+        return 0;
+    }
+
+    Ticket ticket = ++lastTicket;
+    ticketUrls[ticket] = url;
+    waiting[url].emplace_back(ticket, std::move(callback));
+
+    // Join an in-flight load instead of fetching the same image twice
+    if (!loading.insert(url).second) {
+        return ticket;
+    }
+
+    std::vector<std::string> dropped;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.push_back(url);
+        while (queue.size() > maxQueued) {
+            dropped.push_back(std::move(queue.front()));
+            queue.pop_front();
+        }
+    }
+    queueReady.notify_one();
+    for (const std::string &oldest : dropped) {
+        finish(oldest, nullptr);
+    }
+    return ticket;
+}
+
+void ThumbnailCache::cancel(Ticket ticket) {
+    auto found = ticketUrls.find(ticket);
+    if (found == ticketUrls.end()) {
+        return; // Already delivered, or never queued
+    }
+    std::string url = found->second;
+    ticketUrls.erase(found);
+
+    auto &callbacks = waiting[url];
+    callbacks.erase(std::remove_if(callbacks.begin(), callbacks.end(), [ticket](const std::pair<Ticket, Callback> &entry) {
+        return entry.first == ticket;
+    }), callbacks.end());
+    if (!callbacks.empty()) {
+        return;
+    }
+    waiting.erase(url);
+
+    // A worker that already took the URL finishes it; the result is cached
+    std::lock_guard<std::mutex> lock(queueMutex);
+    auto queued = std::find(queue.begin(), queue.end(), url);
+    if (queued != queue.end()) {
+        queue.erase(queued);
+        loading.erase(url);
+    }
+}
+
+void ThumbnailCache::workerLoop() {
+    CURL *curl = curl_easy_init(); // One handle per worker keeps connections alive
+    for (;;) {
+        std::string url;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueReady.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping) {
+                break;
+            }
+            // Newest first: the rows just scrolled into view were requested last
+            url = std::move(queue.back());
+            queue.pop_back();
+        }
+
+        std::string path = diskPath(url);
+        GdkPixbuf *pixbuf = path.empty() ? nullptr : loadFromDisk(path);
+        if (pixbuf) {
+            g_utime(path.c_str(), nullptr); // Recently used: pruned last
+        } else if (curl) {
+            pixbuf = download(curl, url);
+            if (pixbuf && !path.empty()) {
+                GError *error = nullptr;
+                if (gdk_pixbuf_save(pixbuf, path.c_str(), "png", &error, NULL)) {
+                    stored(path);
+                } else {
+                    g_clear_error(&error);
+                }
+            }
+        }
+
+        g_idle_add(deliver, new Delivery{this, alive, url, pixbuf});
+    }
+    if (curl) {
+        curl_easy_cleanup(curl);
+    }
+}
+
+GdkPixbuf *ThumbnailCache::loadFromDisk(const std::string &path) const {
+    GError *error = nullptr;
+    GdkPixbuf *pixbuf = gdk_pixbuf_new_from_file_at_scale(path.c_str(), size, size, TRUE, &error);
+    g_clear_error(&error);
+    return pixbuf;
+}
+
+GdkPixbuf *ThumbnailCache::download(void *handle, const std::string &url) const {
+    CURL *curl = static_cast<CURL *>(handle);
+    std::string body;
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, AppendToBuffer);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 20L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+
+    long status = 0;
+    if (curl_easy_perform(curl) != CURLE_OK) {
+        return nullptr;
+    }
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    if (status != 200 || body.empty()) {
+        return nullptr;
+    }
+
+    int target = size;
+    GdkPixbufLoader *loader = gdk_pixbuf_loader_new();
+    g_signal_connect(loader, "size-prepared", G_CALLBACK(on_size_prepared), &target);
+
+    GError *error = nullptr;
+    GdkPixbuf *pixbuf = nullptr;
+    bool written = gdk_pixbuf_loader_write(loader, reinterpret_cast<const guchar *>(body.data()), body.size(), &error);
+    g_clear_error(&error);
+    if (gdk_pixbuf_loader_close(loader, &error) && written) {
+        pixbuf = gdk_pixbuf_loader_get_pixbuf(loader);
+        if (pixbuf) {
+            g_object_ref(pixbuf);
+        }
+    }
+    g_clear_error(&error);
+    g_object_unref(loader);
+    return pixbuf;
+}
+
+std::string ThumbnailCache::diskPath(const std::string &url) const {
+    if (diskDir.empty()) {
+        return "";
+    }
+    gchar *digest = g_compute_checksum_for_string(G_CHECKSUM_SHA1, url.c_str(), -1);
+    std::string name = std::string(digest) + "-" + std::to_string(size) + ".png";
+    g_free(digest);
+
+    gchar *path = g_build_filename(diskDir.c_str(), name.c_str(), NULL);
+    std::string result = path;
+    g_free(path);
+    return result;
+}
+
+// Insert into the LRU (taking ownership) and evict down to the memory limit
+void ThumbnailCache::remember(const std::string &url, GdkPixbuf *pixbuf) {
+    lru.emplace_front(url, pixbuf);
+    lruIndex[url] = lru.begin();
+    memoryBytes += gdk_pixbuf_get_byte_length(pixbuf);
+
+    while (memoryBytes > memoryLimitBytes && lru.size() > 1) {
+        auto &oldest = lru.back();
+        memoryBytes -= gdk_pixbuf_get_byte_length(oldest.second);
+        lruIndex.erase(oldest.first);
+        g_object_unref(oldest.second);
+        lru.pop_back();
+    }
+}
+
+// Count a file just written to the disk cache and prune if it is over the
+// limit. The first call measures the directory, files from earlier runs
+// included. Runs on the workers.
+void ThumbnailCache::stored(const std::string &path) {
+    std::lock_guard<std::mutex> lock(diskMutex);
+    if (!diskScanned) {
+        diskScanned = true;
+        pruneDisk(diskLimitBytes);
+        return;
+    }
+    GStatBuf info;
+    if (g_stat(path.c_str(), &info) == 0) {
+        diskBytes += static_cast<size_t>(info.st_size);
+    }
+    if (diskBytes > diskLimitBytes) {
+        pruneDisk(diskLimitBytes / 4 * 3); // Headroom, so pruning doesn't run on every download
+    }
+}
+
+// Delete the least recently used files (by modification time; disk hits
+// touch theirs) until the cache fits in targetBytes. Called with diskMutex held.
+void ThumbnailCache::pruneDisk(size_t targetBytes) {
+    struct DiskFile {
+        std::string path;
+        size_t bytes;
+        time_t used;
+    };
+    std::vector<DiskFile> files;
+    size_t total = 0;
+
+    GDir *dir = g_dir_open(diskDir.c_str(), 0, nullptr);
+    if (!dir) {
+        return;
+    }
+    while (const gchar *name = g_dir_read_name(dir)) {
+        gchar *path = g_build_filename(diskDir.c_str(), name, NULL);
+        GStatBuf info;
+        if (g_stat(path, &info) == 0) {
+            files.push_back(DiskFile{path, static_cast<size_t>(info.st_size), info.st_mtime});
+            total += files.back().bytes;
+        }
+        g_free(path);
+    }
+    g_dir_close(dir);
+
+    if (total > targetBytes) {
+        std::sort(files.begin(), files.end(), [](const DiskFile &a, const DiskFile &b) { return a.used < b.used; });
+        for (const DiskFile &file : files) {
+            if (total <= targetBytes) {
+                break;
+            }
+            if (g_remove(file.path.c_str()) == 0) {
+                total -= file.bytes;
+            }
+        }
+    }
+    diskBytes = total;
+}
+
+// Hand a finished load to everyone still waiting for it (main thread)
+void ThumbnailCache::finish(const std::string &url, GdkPixbuf *pixbuf) {
+    loading.erase(url);
+    std::vector<std::pair<Ticket, Callback>> callbacks;
+    auto found = waiting.find(url);
+    if (found != waiting.end()) {
+        callbacks = std::move(found->second);
+        waiting.erase(found);
+    }
+    for (const auto &entry : callbacks) {
+        ticketUrls.erase(entry.first);
+    }
+
+    // Callbacks may add or evict entries, so hold our own reference meanwhile
+    if (pixbuf) {
+        g_object_ref(pixbuf);
+        remember(url, pixbuf);
+    }
+    for (auto &entry : callbacks) {
+        entry.second(pixbuf);
+    }
+    if (pixbuf) {
+        g_object_unref(pixbuf);
+    }
+}
+
+gboolean ThumbnailCache::deliver(gpointer data) {
+    std::unique_ptr<Delivery> delivery(static_cast<Delivery *>(data));
+    if (delivery->alive.expired()) {
+        if (delivery->pixbuf) {
+            g_object_unref(delivery->pixbuf);
+        }
+        return G_SOURCE_REMOVE;
+    }
+
+    delivery->cache->finish(delivery->url, delivery->pixbuf); // Takes the reference
+    return G_SOURCE_REMOVE;
+}
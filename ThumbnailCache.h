@@ -0,0 +1,91 @@
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <gtk/gtk.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Asynchronous thumbnail loader for recipe images.
+// Downloads run on a small worker pool; images are decoded and downscaled on
+// the workers, kept in a bounded in-memory LRU and persisted to a disk cache
+// so a restart doesn't hit the network again. The disk cache is bounded too:
+// once it grows past its limit the least recently used files are deleted.
+// request() and the callbacks it triggers run on the GTK main thread;
+// cancel() drops a request whose row has gone away before it was served.
+class ThumbnailCache {
+public:
+    // Receives the thumbnail, or nullptr if it could not be loaded. The pixbuf
+    // is owned by the cache; take a reference to keep it beyond the callback.
+    using Callback = std::function<void(GdkPixbuf *)>;
+
+    // Identifies a request until its callback has run; 0 if it ran at once
+    using Ticket = size_t;
+
+    explicit ThumbnailCache(int size = 96, size_t memoryLimitBytes = 16 * 1024 * 1024, unsigned workerCount = 4,
+                            size_t diskLimitBytes = 64 * 1024 * 1024, size_t maxQueued = 256);
+    ~ThumbnailCache();
+
+    ThumbnailCache(const ThumbnailCache &) = delete;
+    ThumbnailCache &operator=(const ThumbnailCache &) = delete;
+
+    // Deliver the thumbnail for url; memory hits call back immediately. The
+    // oldest queued requests beyond maxQueued are dropped with nullptr.
+    Ticket request(const std::string &url, Callback callback);
+
+    // Forget a request; its callback won't run. A download nobody else waits
+    // for leaves the queue if no worker has started it.
+    void cancel(Ticket ticket);
+
+private:
+    struct Delivery;
+
+    void workerLoop();
+    GdkPixbuf *loadFromDisk(const std::string &path) const;
+    GdkPixbuf *download(void *curl, const std::string &url) const;
+    std::string diskPath(const std::string &url) const;
+    void remember(const std::string &url, GdkPixbuf *pixbuf);
+    void stored(const std::string &path);
+    void pruneDisk(size_t targetBytes);
+    void finish(const std::string &url, GdkPixbuf *pixbuf);
+    static gboolean deliver(gpointer data);
+
+    const int size;
+    const size_t memoryLimitBytes;
+    const size_t diskLimitBytes;
+    const size_t maxQueued;
+    std::string diskDir;
+
+    // Main-thread state: LRU of decoded thumbnails and waiting callbacks
+    std::list<std::pair<std::string, GdkPixbuf *>> lru;
+    std::unordered_map<std::string, std::list<std::pair<std::string, GdkPixbuf *>>::iterator> lruIndex;
+    size_t memoryBytes = 0;
+    std::unordered_map<std::string, std::vector<std::pair<Ticket, Callback>>> waiting;
+    std::unordered_map<Ticket, std::string> ticketUrls;
+    std::unordered_set<std::string> loading; // Queued or on a worker
+    Ticket lastTicket = 0;
+
+    // Work queue shared with the workers
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::deque<std::string> queue;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+
+    // Disk cache size, known after the first file is stored
+    std::mutex diskMutex;
+    size_t diskBytes = 0;
+    bool diskScanned = false;
+
+    std::shared_ptr<bool> alive; // Lets late deliveries detect destruction
+};
+
+#endif // THUMBNAILCACHE_H
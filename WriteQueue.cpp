@@ -0,0 +1,102 @@
+#include "WriteQueue.h"
+#include <iostream>
+
+WriteQueue::WriteQueue(const std::string &dbPath, std::recursive_mutex &writeMutex, const Options &options,
+                       std::function<void(sqlite3 *)> initializer)
+    : writeMutex(writeMutex), options(options) {
+    // A dedicated connection keeps the durability setting away from the pool
+    if (sqlite3_open_v2(dbPath.c_str(), &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK) {
+        std::cerr << "Failed to open write queue connection: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_close(db);
+        db = nullptr;
+    } else {
+        sqlite3_busy_timeout(db, 5000);
+        if (initializer) {
+            initializer(db);
+        }
+        const char *synchronousSQL = options.durability == Durability::Full
+            ? "PRAGMA synchronous=FULL;" : "PRAGMA synchronous=NORMAL;";
+        sqlite3_exec(db, synchronousSQL, nullptr, nullptr, nullptr);
+    }
+
+    committer = std::thread([this] { committerLoop(); });
+}
+
+WriteQueue::~WriteQueue() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueReady.notify_all();
+    committer.join();
+    if (db) {
+        sqlite3_close(db);
+    }
+}
+
+std::future<bool> WriteQueue::submit(Operation operation) {
+    Pending pending{std::move(operation), std::promise<bool>()};
+    std::future<bool> result = pending.done.get_future();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.push_back(std::move(pending));
+    }
+    queueReady.notify_one();
+    return result;
+}
+
+void WriteQueue::committerLoop() {
+    std::vector<Pending> batch;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueReady.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return; // Stopping and fully drained
+            }
+
+            // Give other producers one window to join this batch
+            if (options.batchWindow.count() > 0) {
+                auto deadline = std::chrono::steady_clock::now() + options.batchWindow;
+                queueReady.wait_until(lock, deadline, [this] { return stopping || queue.size() >= options.maxBatch; });
+            }
+
+            size_t take = std::min(queue.size(), options.maxBatch);
+            batch.assign(std::make_move_iterator(queue.begin()), std::make_move_iterator(queue.begin() + take));
+            queue.erase(queue.begin(), queue.begin() + take);
+        }
+
+        commitBatch(batch);
+        batch.clear();
+    }
+}
+
+void WriteQueue::commitBatch(std::vector<Pending> &batch) {
+    std::vector<bool> results(batch.size(), false);
+    bool committed = false;
+    {
+        std::lock_guard<std::recursive_mutex> writeLock(writeMutex);
+        if (db && sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) == SQLITE_OK) {
+            for (size_t i = 0; i < batch.size(); ++i) {
+                sqlite3_exec(db, "SAVEPOINT queued_write;", nullptr, nullptr, nullptr);
+                results[i] = batch[i].operation(db);
+                if (results[i]) {
+                    sqlite3_exec(db, "RELEASE queued_write;", nullptr, nullptr, nullptr);
+                } else {
+                    sqlite3_exec(db, "ROLLBACK TO queued_write; RELEASE queued_write;", nullptr, nullptr, nullptr);
+                }
+            }
+            committed = sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) == SQLITE_OK;
+            if (!committed) {
+                std::cerr << "Failed to commit write batch: " << sqlite3_errmsg(db) << std::endl;
+                sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            }
+        } else {
+            std::cerr << "Failed to begin write batch: " << (db ? sqlite3_errmsg(db) : "no connection") << std::endl;
+        }
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        batch[i].done.set_value(committed && results[i]);
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef WRITEQUEUE_H
+#define WRITEQUEUE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sqlite3.h>
+
+// Group-commit queue for small writes from many producers.
+// Writes submitted within one batch window share a single transaction, so
+// concurrent producers pay for one commit (and one fsync) per batch instead
+// of one per write. Each write runs in its own savepoint, so a failing write
+// only fails its own future.
+class WriteQueue {
+public:
+    // How hard each batch commit pushes data to disk (PRAGMA synchronous)
+    enum class Durability { Full, Normal };
+
+    struct Options {
+        // Extra time to wait for more writes before committing. With 0, writes
+        // that arrive while a commit is in flight form the next batch.
+        std::chrono::microseconds batchWindow{0};
+        size_t maxBatch = 256;
+        Durability durability = Durability::Full;
+    };
+
+    // A write to run on the queue's connection; returns false on failure
+    using Operation = std::function<bool(sqlite3 *)>;
+
+    // writeMutex is held while a batch commits, so batches don't interleave
+    // with the owner's synchronous writes
+    WriteQueue(const std::string &dbPath, std::recursive_mutex &writeMutex, const Options &options,
+               std::function<void(sqlite3 *)> initializer = nullptr);
+    ~WriteQueue(); // Commits everything still queued
+
+    WriteQueue(const WriteQueue &) = delete;
+    WriteQueue &operator=(const WriteQueue &) = delete;
+
+    // Queue a write; the future becomes ready once its batch has committed
+    std::future<bool> submit(Operation operation);
+
+private:
+    struct Pending {
+        Operation operation;
+        std::promise<bool> done;
+    };
+
+    void committerLoop();
+    void commitBatch(std::vector<Pending> &batch);
+
+    sqlite3 *db = nullptr;
+    std::recursive_mutex &writeMutex;
+    Options options;
+
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::vector<Pending> queue;
+    bool stopping = false;
+    std::thread committer;
+};
+
+#endif // WRITEQUEUE_H
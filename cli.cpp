@@ -0,0 +1,922 @@
+// Headless batch entry point: runs recipe commands without starting GTK.
+//
+// Usage: recipe_cli [--db PATH] [--batch N] [--import-threads N] [--export-threads N] [--undo-window S] [API OPTIONS] [FILE]
+//        recipe_cli [--db PATH] --stress THREADS [--ops N]
+//        recipe_cli [--db PATH] --bench-writes MAX_PRODUCERS [--ops N] [--durability full|normal] [--window US]
+//        recipe_cli [--db PATH] --bench-formats RECIPES
+//        recipe_cli --bench-meal-json MEALS|RESPONSE_FILE
+//        recipe_cli [API OPTIONS] --bench-api REQUESTS
+//
+// API OPTIONS: --api-rate N (requests per second, 0 = unlimited), --no-hedge,
+// --api-cooldown MS (how long the circuit breaker stays open)
+//
+// Commands are read one per line from FILE (or stdin when FILE is omitted
+// or "-"). Consecutive writes are grouped into transactions of up to N
+// commands so a bulk load pays for one commit per batch instead of one per
+// recipe. Blank lines and lines starting with '#' are ignored. JSON imports
+// are parsed on --import-threads threads and exports are serialized on
+// --export-threads threads (default: one per core for both). A clear can be
+// undone for --undo-window seconds (default 60) before its rows are deleted.
+//
+//   add NAME|INGREDIENT,INGREDIENT,...|CATEGORY|INSTRUCTIONS
+//   update NAME|CHANGE|...   (name=X, category=X, instructions=X, favorite=0|1,
+//                             +INGREDIENT, -INGREDIENT)
+//   favorite NAME
+//   delete NAME
+//   import FILE
+//   import-from OFFSET FILE  (NDJSON from a byte offset; prints the next offset)
+//   import-resumable FILE    (commits every 10000 recipes; rerun resumes after a crash)
+//   export FILE
+//   append FILE              (NDJSON: add every recipe to the end of FILE)
+//   export-changes SEQ FILE  (changes after SEQ; prints the new SEQ)
+//   apply-changes FILE       (prints the SEQ the file goes up to)
+//   clear
+//   undo-clear               (brings back the recipes of the last clear)
+//   maintain                 (runs the idle-time maintenance now; prints each task)
+//   list
+//   favorites
+//   category NAME
+//   local-search INGREDIENT  (saved recipes that use it)
+//   get ID [ID ...]          (saved recipes by database ID, through the cache)
+//   find QUERY               (saved recipes, then TheMealDB hits as they arrive)
+//   search INGREDIENT[,...]  (TheMealDB, no database access; recipes with all of them)
+//   instructions ID          (TheMealDB, no database access)
+//   import-remote ID [ID ...]
+//                            (saves TheMealDB recipes; a saved one with the same
+//                             name keeps its content)
+//   sync-mealdb [THREADS]    (mirrors the TheMealDB catalog; rerun resumes or refreshes)
+//   api-stats                (TheMealDB client counters and breaker state)
+//
+// --stress runs a mixed read/write workload against one shared RecipeManager
+// from THREADS threads and checks that no write was lost. Build with
+// -fsanitize=thread to check the locking as well.
+//
+// --bench-writes compares per-call commits (addRecipe) with the group-commit
+// queue (addRecipeAsync) for 1, 2, 4, ... MAX_PRODUCERS concurrent producers,
+// each waiting for its own write before issuing the next.
+//
+// --bench-formats fills the database up to RECIPES synthetic recipes, then
+// prints file size, export time, parse time and import time (into an empty
+// database) for every export format.
+//
+// --bench-meal-json times reading TheMealDB responses into recipes: a full
+// JSON parse against the lazy MealJsonReader, on MEALS synthetic meals or a
+// saved response, and checks that both give the same recipes.
+//
+// --bench-api looks up the Beef recipes of TheMealDB (or MEALDB_API_URL)
+// one after another, REQUESTS times, and prints the latency percentiles
+// with the client's hedge, failure and breaker counters.
+#include "RecipeManager.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct BatchStats {
+    size_t commands = 0;
+    size_t writes = 0;
+    size_t failures = 0;
+    size_t transactions = 0;
+};
+
+// Keeps a write transaction open across consecutive write commands
+class BatchWriter {
+public:
+    BatchWriter(RecipeManager &manager, size_t batchSize, BatchStats &stats)
+        : manager(manager), batchSize(batchSize), stats(stats) {}
+
+    ~BatchWriter() { flush(); }
+
+    // Open a transaction if none is pending; returns false if that failed
+    bool beforeWrite() {
+        if (pending == 0 && batchSize > 1) {
+            if (!manager.beginTransaction()) {
+                return false;
+            }
+            open = true;
+        }
+        return true;
+    }
+
+    void afterWrite() {
+        ++pending;
+        if (pending >= batchSize) {
+            flush();
+        }
+    }
+
+    // Commit whatever is pending (before reads of external state and at exit)
+    void flush() {
+        if (open) {
+            if (!manager.commitTransaction()) {
+                manager.rollbackTransaction();
+                stats.failures += pending;
+            }
+            ++stats.transactions;
+        } else if (pending > 0) {
+            stats.transactions += pending;
+        }
+        open = false;
+        pending = 0;
+    }
+
+private:
+    RecipeManager &manager;
+    size_t batchSize;
+    BatchStats &stats;
+    size_t pending = 0;
+    bool open = false;
+};
+
+// Split "a,b , c" into trimmed ingredient names
+std::vector<std::string> splitIngredients(const std::string &text) {
+    std::vector<std::string> ingredients;
+    std::istringstream iss(text);
+    std::string ingredient;
+    while (std::getline(iss, ingredient, ',')) {
+        size_t start = ingredient.find_first_not_of(" \t");
+        size_t end = ingredient.find_last_not_of(" \t");
+        if (start != std::string::npos) {
+            ingredients.push_back(ingredient.substr(start, end - start + 1));
+        }
+    }
+    return ingredients;
+}
+
+// Expand "\n" escapes so multi-line instructions fit on one command line
+std::string unescape(const std::string &text) {
+    std::string result;
+    result.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\\' && i + 1 < text.size()) {
+            char next = text[i + 1];
+            if (next == 'n') { result += '\n'; ++i; continue; }
+            if (next == 't') { result += '\t'; ++i; continue; }
+            if (next == '\\') { result += '\\'; ++i; continue; }
+        }
+        result += text[i];
+    }
+    return result;
+}
+
+// Parse a whole decimal number; false if text is anything else or out of
+// range for Number
+template <typename Number>
+bool parseNumber(const std::string &text, Number &value) {
+    const char *end = text.data() + text.size();
+    std::from_chars_result parsed = std::from_chars(text.data(), end, value);
+    return parsed.ec == std::errc() && parsed.ptr == end;
+}
+
+bool runAdd(RecipeManager &manager, const std::string &args) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    for (int i = 0; i < 3; ++i) {
+        size_t bar = args.find('|', start);
+        if (bar == std::string::npos) {
+            std::cerr << "add: expected NAME|INGREDIENTS|CATEGORY|INSTRUCTIONS" << std::endl;
+            return false;
+        }
+        fields.push_back(args.substr(start, bar - start));
+        start = bar + 1;
+    }
+    fields.push_back(args.substr(start));
+
+    return manager.addRecipe(fields[0], splitIngredients(fields[1]), fields[2], unescape(fields[3]));
+}
+
+// update NAME|CHANGE|CHANGE...: each change is name=, category=,
+// instructions=, favorite=0|1, +INGREDIENT or -INGREDIENT
+bool runUpdate(RecipeManager &manager, const std::string &args) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    for (size_t bar; (bar = args.find('|', start)) != std::string::npos; start = bar + 1) {
+        fields.push_back(args.substr(start, bar - start));
+    }
+    fields.push_back(args.substr(start));
+
+    RecipePatch patch;
+    for (size_t i = 1; i < fields.size(); ++i) {
+        const std::string &change = fields[i];
+        size_t equals = change.find('=');
+        std::string field = change.substr(0, equals);
+        std::string value = (equals == std::string::npos) ? "" : change.substr(equals + 1);
+        if (!change.empty() && change[0] == '+') {
+            patch.addIngredients.push_back(change.substr(1));
+        } else if (!change.empty() && change[0] == '-') {
+            patch.removeIngredients.push_back(change.substr(1));
+        } else if (equals != std::string::npos && field == "name") {
+            patch.name = value;
+        } else if (equals != std::string::npos && field == "category") {
+            patch.category = value;
+        } else if (equals != std::string::npos && field == "instructions") {
+            patch.instructions = unescape(value);
+        } else if (equals != std::string::npos && field == "favorite") {
+            patch.isFavorite = value == "1";
+        } else {
+            std::cerr << "update: unknown change '" << change << "'" << std::endl;
+            return false;
+        }
+    }
+
+    int id = manager.findRecipeId(fields[0]);
+    if (id == 0) {
+        std::cerr << "update: no recipe named '" << fields[0] << "'" << std::endl;
+        return false;
+    }
+    return manager.updateRecipe(id, patch) != RecipeManager::UpsertResult::Failed;
+}
+
+// One line per recipe: name, category, ingredients and favorite flag
+void printRecipes(const std::vector<Recipe> &recipes) {
+    for (const auto &recipe : recipes) {
+        std::cout << recipe.name << " (" << recipe.category << "): ";
+        for (size_t i = 0; i < recipe.ingredients.size(); ++i) {
+            std::cout << (i ? ", " : "") << recipe.ingredients[i];
+        }
+        std::cout << (recipe.isFavorite ? " [favorite]" : "") << "\n";
+    }
+}
+
+// One line of TheMealDB client counters, as printed by api-stats
+void printApiStats(const MealDbClient::Stats &api) {
+    static const char *breakerNames[] = {"closed", "open", "half-open"};
+    std::cout << "requests=" << api.requests << " shared=" << api.joined << " cached=" << api.cached
+              << " throttled_ms=" << api.throttled.count() / 1000 << " hedges=" << api.hedges
+              << " hedge_wins=" << api.hedgeWins << " failures=" << api.failures << " rejected=" << api.rejected
+              << " stale=" << api.staleServed << " p95_ms=" << api.p95.count()
+              << " breaker=" << breakerNames[static_cast<int>(api.breaker)] << "\n";
+}
+
+// Execute one command line; returns false if the command failed
+bool runCommand(RecipeManager &manager, BatchWriter &batch, BatchStats &stats, const std::string &line) {
+    size_t space = line.find(' ');
+    std::string command = line.substr(0, space);
+    std::string args = (space == std::string::npos) ? "" : line.substr(space + 1);
+
+    if (command == "add" || command == "update" || command == "favorite" || command == "delete") {
+        if (!batch.beforeWrite()) {
+            return false;
+        }
+        ++stats.writes;
+        bool ok = (command == "add") ? runAdd(manager, args)
+                : (command == "update") ? runUpdate(manager, args)
+                : (command == "favorite") ? manager.toggleFavorite(args)
+                : manager.deleteRecipe(args);
+        batch.afterWrite();
+        return ok;
+    }
+    if (command == "import") {
+        if (!batch.beforeWrite()) {
+            return false;
+        }
+        ++stats.writes;
+        bool ok = manager.importRecipes(args);
+        batch.afterWrite();
+        return ok;
+    }
+    if (command == "clear") {
+        batch.flush();
+        ++stats.writes;
+        manager.clearDatabase();
+        return true;
+    }
+    if (command == "undo-clear") {
+        batch.flush();
+        ++stats.writes;
+        return manager.undoClear();
+    }
+    if (command == "maintain") {
+        batch.flush();
+        bool ok = manager.runMaintenance();
+        for (const MaintenanceScheduler::TaskStatus &task : manager.maintenanceStatus()) {
+            std::cout << task.name << "\t" << task.runs << " runs\t" << (task.ok ? "ok" : "failed") << "\t"
+                      << task.lastDuration.count() << " us\t" << task.detail << "\n";
+        }
+        return ok;
+    }
+    if (command == "import-resumable") {
+        batch.flush(); // Commits per batch on its own
+        ++stats.writes;
+        return manager.importRecipesCheckpointed(args);
+    }
+    if (command == "import-from") {
+        size_t split = args.find(' ');
+        if (split == std::string::npos) {
+            std::cerr << "import-from: expected OFFSET FILE" << std::endl;
+            return false;
+        }
+        std::string path = args.substr(split + 1);
+        uint64_t fromOffset = 0;
+        if (!parseNumber(args.substr(0, split), fromOffset)) {
+            std::cerr << "import-from: OFFSET must be a number, got '" << args.substr(0, split) << "'" << std::endl;
+            return false;
+        }
+        if (!batch.beforeWrite()) {
+            return false;
+        }
+        ++stats.writes;
+        uint64_t endOffset = 0;
+        bool ok = manager.importRecipes(path, recipeFormatForPath(path), fromOffset, &endOffset);
+        batch.afterWrite();
+        if (ok) {
+            std::cout << endOffset << "\n";
+        }
+        return ok;
+    }
+    if (command == "apply-changes") {
+        if (!batch.beforeWrite()) {
+            return false;
+        }
+        ++stats.writes;
+        int64_t untilSeq = 0;
+        bool ok = manager.applyChanges(args, &untilSeq);
+        batch.afterWrite();
+        if (ok) {
+            std::cout << untilSeq << "\n";
+        }
+        return ok;
+    }
+    if (command == "export") {
+        return manager.exportRecipes(args);
+    }
+    if (command == "append") {
+        return manager.exportRecipes(args, recipeFormatForPath(args), true);
+    }
+    if (command == "export-changes") {
+        size_t split = args.find(' ');
+        if (split == std::string::npos) {
+            std::cerr << "export-changes: expected SEQ FILE" << std::endl;
+            return false;
+        }
+        int64_t sinceSeq = 0;
+        if (!parseNumber(args.substr(0, split), sinceSeq)) {
+            std::cerr << "export-changes: SEQ must be a number, got '" << args.substr(0, split) << "'" << std::endl;
+            return false;
+        }
+        int64_t untilSeq = 0;
+        if (!manager.exportChangesSince(sinceSeq, args.substr(split + 1), &untilSeq)) {
+            return false;
+        }
+        std::cout << untilSeq << "\n";
+        return true;
+    }
+    if (command == "list") {
+        printRecipes(manager.listAllRecipes());
+        return true;
+    }
+    if (command == "favorites") {
+        std::cout << manager.listFavoriteRecipes();
+        return true;
+    }
+    if (command == "category") {
+        std::cout << manager.filterRecipesByCategory(args);
+        return true;
+    }
+    if (command == "get") {
+        std::vector<int> ids;
+        std::istringstream iss(args);
+        int id;
+        while (iss >> id) {
+            ids.push_back(id);
+        }
+        std::vector<Recipe> recipes = manager.getRecipes(ids);
+        printRecipes(recipes);
+        if (recipes.size() < ids.size()) {
+            std::cerr << "get: " << ids.size() - recipes.size() << " of " << ids.size() << " recipes not found" << std::endl;
+            return false;
+        }
+        return true;
+    }
+    if (command == "find") {
+        batch.flush();
+        std::promise<void> finished;
+        manager.searchAll(args, RecipeManager::SearchOptions(), [&](RecipeManager::SearchSource source, const std::vector<Recipe> &recipes, bool last) {
+            for (const auto &recipe : recipes) {
+                if (source == RecipeManager::SearchSource::Local) {
+                    std::cout << "saved: " << recipe.name << " (" << recipe.category << ")\n";
+                } else {
+                    std::cout << "TheMealDB: ID: " << recipe.id << " - " << recipe.name << "\n";
+                }
+            }
+            std::cout.flush();
+            if (last) {
+                finished.set_value();
+            }
+        });
+        finished.get_future().wait();
+        return true;
+    }
+    if (command == "local-search") {
+        printRecipes(manager.searchLocalByIngredient(args));
+        return true;
+    }
+    if (command == "search") {
+        // Don't hold the write lock across a network round trip
+        batch.flush();
+        std::vector<std::string> ingredients = splitIngredients(args);
+        std::vector<Recipe> recipes = ingredients.size() > 1 ? manager.searchByIngredients(ingredients) : manager.searchByIngredient(args);
+        for (const auto &recipe : recipes) {
+            std::cout << "ID: " << recipe.id << " - " << recipe.name << "\n";
+        }
+        return true;
+    }
+    if (command == "instructions") {
+        batch.flush();
+        std::cout << manager.getRecipeInstructions(std::atoi(args.c_str())) << "\n";
+        return true;
+    }
+    if (command == "import-remote") {
+        batch.flush();
+        std::vector<int> ids;
+        std::istringstream iss(args);
+        int id;
+        while (iss >> id) {
+            ids.push_back(id);
+        }
+        size_t saved = manager.importRemoteRecipes(ids);
+        std::cout << "Saved " << saved << " of " << ids.size() << " TheMealDB recipes\n";
+        return saved == ids.size();
+    }
+    if (command == "sync-mealdb") {
+        batch.flush();
+        RecipeManager::MirrorOptions options;
+        if (!args.empty()) {
+            options.threads = static_cast<size_t>(std::max(1, std::atoi(args.c_str())));
+        }
+        RecipeManager::MirrorReport report = manager.syncMealDbMirror(options);
+        std::cout << (report.complete ? "Mirror complete" : "Mirror incomplete, run again to resume") << ": "
+                  << report.pages << " pages downloaded, " << report.unchanged << " unchanged, "
+                  << report.skipped << " already done, " << report.failed << " failed, "
+                  << report.lookups << " lookups, " << report.written << " recipes written\n";
+        return report.complete;
+    }
+    if (command == "api-stats") {
+        printApiStats(manager.mealDbStats());
+        return true;
+    }
+
+    std::cerr << "Unknown command: " << command << std::endl;
+    return false;
+}
+
+// Hammer one manager from many threads; returns false if writes went missing
+bool runStress(RecipeManager &manager, int threadCount, int opsPerThread) {
+    static const char *categories[] = {"Breakfast", "Lunch", "Dinner", "Dessert"};
+    std::atomic<size_t> expectedAdds{0};
+    std::atomic<size_t> failures{0};
+
+    auto worker = [&](int thread) {
+        std::minstd_rand random(thread + 1);
+        int added = 0;
+        auto nextName = [&] { return "stress-" + std::to_string(thread) + "-" + std::to_string(added++); };
+
+        for (int op = 0; op < opsPerThread; ++op) {
+            int roll = static_cast<int>(random() % 100);
+            bool ok = true;
+            if (roll < 40) {
+                ok = manager.addRecipe(nextName(), {"flour", "water"}, categories[op % 4], "Mix.");
+                expectedAdds += ok ? 1 : 0;
+            } else if (roll < 55) {
+                if (added > 0) {
+                    ok = manager.toggleFavorite("stress-" + std::to_string(thread) + "-" + std::to_string(random() % added));
+                }
+            } else if (roll < 65) {
+                ok = manager.beginTransaction();
+                if (ok) {
+                    size_t batchAdds = 0;
+                    for (int i = 0; i < 5; ++i) {
+                        batchAdds += manager.addRecipe(nextName(), {"salt"}, categories[i % 4], "Batch.") ? 1 : 0;
+                    }
+                    ok = manager.commitTransaction();
+                    if (ok) {
+                        expectedAdds += batchAdds;
+                    } else {
+                        manager.rollbackTransaction();
+                    }
+                }
+            } else if (roll < 80) {
+                manager.listFavoriteRecipes();
+            } else if (roll < 95) {
+                manager.filterRecipesByCategory(categories[roll % 4]);
+            } else {
+                manager.listAllRecipes();
+            }
+            if (!ok) {
+                ++failures;
+            }
+        }
+    };
+
+    auto started = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back(worker, i);
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    size_t stored = 0;
+    for (const auto &recipe : manager.listAllRecipes()) {
+        stored += recipe.name.compare(0, 7, "stress-") == 0 ? 1 : 0;
+    }
+
+    size_t totalOps = static_cast<size_t>(threadCount) * opsPerThread;
+    std::cerr << "stress: " << threadCount << " threads, " << totalOps << " operations in " << seconds << " s ("
+              << (seconds > 0 ? totalOps / seconds : 0.0) << " ops/s), " << failures << " failed, "
+              << stored << " stress recipes stored, " << expectedAdds << " expected" << std::endl;
+    return failures == 0 && stored == expectedAdds;
+}
+
+// Writes per second for producers each issuing opsPerProducer waited-on writes
+double measureWrites(int producers, int opsPerProducer, const std::function<bool(int, int)> &write) {
+    auto started = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&write, p, opsPerProducer] {
+            for (int op = 0; op < opsPerProducer; ++op) {
+                write(p, op);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return seconds > 0 ? producers * opsPerProducer / seconds : 0.0;
+}
+
+// Print the throughput curve of synchronous vs group-committed writes
+void runWriteBenchmark(const std::string &dbPath, int maxProducers, int opsPerProducer, const WriteQueue::Options &options) {
+    RecipeManager manager(dbPath);
+    manager.configureWriteQueue(options);
+
+    std::cout << "producers\tsync ops/s\tqueued ops/s\n";
+    for (int producers = 1; producers <= maxProducers; producers *= 2) {
+        std::string prefix = "bench-" + std::to_string(producers) + "-";
+        double sync = measureWrites(producers, opsPerProducer, [&](int p, int op) {
+            return manager.addRecipe(prefix + "s" + std::to_string(p) + "-" + std::to_string(op), {"flour"}, "Lunch", "Bake.");
+        });
+        double queued = measureWrites(producers, opsPerProducer, [&](int p, int op) {
+            return manager.addRecipeAsync(prefix + "q" + std::to_string(p) + "-" + std::to_string(op), {"flour"}, "Lunch", "Bake.").get();
+        });
+        std::cout << producers << "\t" << static_cast<long>(sync) << "\t" << static_cast<long>(queued) << "\n";
+    }
+}
+
+// Seconds taken by one call
+double timeIt(const std::function<void()> &work) {
+    auto started = std::chrono::steady_clock::now();
+    work();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+}
+
+// Compare export formats on a catalog of the given size
+void runFormatBenchmark(const std::string &dbPath, size_t recipeCount) {
+    static const char *categories[] = {"Breakfast", "Lunch", "Dinner", "Dessert"};
+    RecipeManager manager(dbPath);
+    size_t stored = manager.listAllRecipes().size();
+    if (stored < recipeCount && manager.beginTransaction()) {
+        for (size_t i = stored; i < recipeCount; ++i) {
+            Recipe recipe;
+            recipe.name = "format-bench-" + std::to_string(i);
+            recipe.ingredients = {"flour", "water", "salt", "ingredient " + std::to_string(i % 97)};
+            recipe.category = categories[i % 4];
+            recipe.instructions = "Mix everything.\nBake for " + std::to_string(20 + i % 40) + " minutes.";
+            recipe.isFavorite = i % 7 == 0;
+            manager.upsertRecipe(recipe);
+        }
+        manager.commitTransaction();
+    }
+
+    struct Format {
+        const char *name;
+        const char *extension;
+    };
+    static const Format formats[] = {{"json", "json"}, {"ndjson", "ndjson"}, {"cbor", "cbor"}, {"msgpack", "msgpack"}, {"bson", "bson"}};
+
+    std::cout << "format\tbytes\texport s\tparse s\timport s\n";
+    for (const Format &format : formats) {
+        std::string exportPath = dbPath + ".bench." + format.extension;
+        std::string importDb = dbPath + ".bench-import.db";
+        bool ok = true;
+        double exportSeconds = timeIt([&] { ok = manager.exportRecipes(exportPath); });
+
+        size_t parsed = 0;
+        double parseSeconds = timeIt([&] {
+            std::ifstream in(exportPath, std::ios::binary);
+            ok = readRecipes(in, recipeFormatForPath(exportPath), [&parsed](nlohmann::json &&) { ++parsed; return true; }) && ok;
+        });
+
+        double importSeconds = timeIt([&] {
+            RecipeManager target(importDb);
+            ok = target.importRecipes(exportPath) && ok;
+        });
+
+        std::ifstream sized(exportPath, std::ios::binary | std::ios::ate);
+        std::cout << format.name << "\t" << static_cast<long long>(sized.tellg()) << "\t" << exportSeconds << "\t"
+                  << parseSeconds << "\t" << importSeconds << (ok && parsed >= recipeCount ? "" : "\tFAILED") << "\n";
+
+        std::remove(exportPath.c_str());
+        for (const char *suffix : {"", "-wal", "-shm"}) {
+            std::remove((importDb + suffix).c_str());
+        }
+    }
+}
+
+// The DOM path recipesFromMealJson() replaced: parse the whole response,
+// then read the fields
+std::vector<Recipe> recipesFromMealDom(const std::string &body) {
+    std::vector<Recipe> recipes;
+    nlohmann::json jsonData = nlohmann::json::parse(body, nullptr, false);
+    if (jsonData.is_discarded() || !jsonData.is_object() || !jsonData["meals"].is_array()) {
+        return recipes;
+    }
+    auto text = [](const nlohmann::json &meal, const std::string &field) {
+        auto found = meal.find(field);
+        return (found != meal.end() && found->is_string()) ? found->get<std::string>() : std::string();
+    };
+    for (const auto &meal : jsonData["meals"]) {
+        if (!meal.is_object()) {
+            continue;
+        }
+        Recipe recipe;
+        recipe.id = std::atoi(text(meal, "idMeal").c_str());
+        recipe.name = text(meal, "strMeal");
+        recipe.category = text(meal, "strCategory");
+        recipe.instructions = text(meal, "strInstructions");
+        recipe.thumbnailUrl = text(meal, "strMealThumb");
+        for (int i = 1; i <= 20; ++i) {
+            std::string ingredient = text(meal, "strIngredient" + std::to_string(i));
+            size_t start = ingredient.find_first_not_of(" \t");
+            if (start != std::string::npos) {
+                recipe.ingredients.push_back(ingredient.substr(start, ingredient.find_last_not_of(" \t") - start + 1));
+            }
+        }
+        if (recipe.id > 0 && !recipe.name.empty()) {
+            recipes.push_back(recipe);
+        }
+    }
+    return recipes;
+}
+
+// A search.php-style response of `count` whole meals, with every field
+// TheMealDB sends
+std::string makeMealResponse(size_t count) {
+    static const char *areas[] = {"British", "Italian", "Japanese", "Mexican"};
+    nlohmann::json meals = nlohmann::json::array();
+    for (size_t i = 0; i < count; ++i) {
+        nlohmann::json meal;
+        meal["idMeal"] = std::to_string(52700 + i);
+        meal["strMeal"] = "Bench Meal " + std::to_string(i) + " à la \"maison\"";
+        meal["strDrinkAlternate"] = nullptr;
+        meal["strCategory"] = "Category " + std::to_string(i % 14);
+        meal["strArea"] = areas[i % 4];
+        std::string instructions;
+        for (int step = 1; step <= 12; ++step) {
+            instructions += "STEP " + std::to_string(step) + "\r\nHeat the pan, add the ingredients and stir for " + std::to_string(step * 3) + " minutes until golden.\r\n";
+        }
+        meal["strInstructions"] = instructions;
+        meal["strMealThumb"] = "https://www.themealdb.com/images/media/meals/bench" + std::to_string(i) + ".jpg";
+        meal["strTags"] = "Meat,Casserole";
+        meal["strYoutube"] = "https://www.youtube.com/watch?v=bench" + std::to_string(i);
+        for (int k = 1; k <= 20; ++k) {
+            bool used = k <= 6 + static_cast<int>(i % 10);
+            meal["strIngredient" + std::to_string(k)] = used ? "Ingredient " + std::to_string((i * k) % 300) : "";
+            meal["strMeasure" + std::to_string(k)] = used ? std::to_string(k * 25) + "g" : " ";
+        }
+        meal["strSource"] = "https://example.com/recipes/" + std::to_string(i);
+        meal["strImageSource"] = nullptr;
+        meal["strCreativeCommonsConfirmed"] = nullptr;
+        meal["dateModified"] = nullptr;
+        meals.push_back(meal);
+    }
+    return nlohmann::json{{"meals", meals}}.dump();
+}
+
+// Time the DOM parse against the lazy reader on one response: a recorded
+// file, or `source` synthetic meals if it is a number
+void runMealJsonBenchmark(const std::string &source) {
+    std::string body;
+    if (!source.empty() && source.find_first_not_of("0123456789") == std::string::npos) {
+        body = makeMealResponse(static_cast<size_t>(std::atol(source.c_str())));
+    } else {
+        std::ifstream in(source, std::ios::binary);
+        if (!in) {
+            std::cerr << "Failed to open response file: " << source << std::endl;
+            return;
+        }
+        body.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    auto same = [](const std::vector<Recipe> &a, const std::vector<Recipe> &b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const Recipe &x, const Recipe &y) {
+            return x.id == y.id && x.name == y.name && x.category == y.category && x.instructions == y.instructions &&
+                   x.thumbnailUrl == y.thumbnailUrl && x.ingredients == y.ingredients;
+        });
+    };
+    std::vector<Recipe> dom = recipesFromMealDom(body);
+    std::vector<Recipe> lazy = recipesFromMealJson(body);
+
+    int rounds = static_cast<int>(std::max<size_t>(3, (200u << 20) / std::max<size_t>(body.size(), 1)));
+    size_t meals = 0;
+    double domSeconds = timeIt([&] {
+        for (int i = 0; i < rounds; ++i) {
+            meals += recipesFromMealDom(body).size();
+        }
+    });
+    double lazySeconds = timeIt([&] {
+        for (int i = 0; i < rounds; ++i) {
+            meals += recipesFromMealJson(body).size();
+        }
+    });
+
+    double megabytes = static_cast<double>(body.size()) * rounds / (1 << 20);
+    std::cout << "reader\tMB/s\tus/response\n";
+    std::cout << "dom\t" << megabytes / domSeconds << "\t" << domSeconds * 1e6 / rounds << "\n";
+    std::cout << "lazy\t" << megabytes / lazySeconds << "\t" << lazySeconds * 1e6 / rounds << "\n";
+    std::cout << body.size() << " bytes, " << lazy.size() << " meals, " << rounds << " rounds, speedup "
+              << domSeconds / lazySeconds << "x" << (same(dom, lazy) ? "" : ", RESULTS DIFFER") << "\n";
+}
+
+// Sequential lookups through one client; returns false if no request
+// could be made
+bool runApiBenchmark(const MealDbClient::Options &options, int requests) {
+    auto client = std::make_unique<MealDbClient>(options);
+    MealDbClient::Response listed = client->get("filter.php?c=Beef");
+    std::vector<Recipe> meals = listed ? recipesFromMealJson(*listed) : std::vector<Recipe>();
+    if (meals.empty()) {
+        std::cerr << "Failed to list the Beef recipes to look up" << std::endl;
+        return false;
+    }
+
+    std::vector<double> millis;
+    size_t missing = 0;
+    for (int i = 0; i < requests; ++i) {
+        std::string endpoint = "lookup.php?i=" + std::to_string(meals[i % meals.size()].id);
+        MealDbClient::Response response;
+        millis.push_back(timeIt([&] { response = client->get(endpoint); }) * 1000);
+        missing += (response && !recipesFromMealJson(*response).empty()) ? 0 : 1;
+    }
+    std::sort(millis.begin(), millis.end());
+    auto percentile = [&](double p) {
+        return millis[std::min(millis.size() - 1, static_cast<size_t>(std::ceil(p * millis.size())) - 1)];
+    };
+    std::cout << "requests\tp50_ms\tp99_ms\tmax_ms\tmissing\n";
+    std::cout << requests << "\t" << percentile(0.5) << "\t" << percentile(0.99) << "\t" << millis.back() << "\t" << missing << "\n";
+    printApiStats(client->stats());
+    return true;
+}
+
+void printUsage() {
+    std::cerr << "Usage: recipe_cli [--db PATH] [--batch N] [--import-threads N] [--export-threads N] [--undo-window S] [API OPTIONS] [FILE]" << std::endl;
+    std::cerr << "       recipe_cli [--db PATH] --stress THREADS [--ops N]" << std::endl;
+    std::cerr << "       recipe_cli [--db PATH] --bench-writes MAX_PRODUCERS [--ops N] [--durability full|normal] [--window US]" << std::endl;
+    std::cerr << "       recipe_cli [--db PATH] --bench-formats RECIPES" << std::endl;
+    std::cerr << "       recipe_cli --bench-meal-json MEALS|RESPONSE_FILE" << std::endl;
+    std::cerr << "       recipe_cli [API OPTIONS] --bench-api REQUESTS" << std::endl;
+    std::cerr << "API OPTIONS: [--api-rate N] [--no-hedge] [--api-cooldown MS]" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string dbPath = "recipes.db";
+    std::string inputPath = "-";
+    size_t batchSize = 500;
+    int stressThreads = 0;
+    int stressOps = 200;
+    int benchProducers = 0;
+    long benchRecipes = 0;
+    std::string benchMealJson;
+    int benchApiRequests = 0;
+    size_t importThreads = 0;
+    size_t exportThreads = 0;
+    int undoWindow = 60;
+    WriteQueue::Options queueOptions;
+    MealDbClient::Options apiOptions;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--db") == 0 && i + 1 < argc) {
+            dbPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            long value = std::atol(argv[++i]);
+            batchSize = value > 0 ? static_cast<size_t>(value) : 1;
+        } else if (std::strcmp(argv[i], "--import-threads") == 0 && i + 1 < argc) {
+            importThreads = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--export-threads") == 0 && i + 1 < argc) {
+            exportThreads = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--undo-window") == 0 && i + 1 < argc) {
+            undoWindow = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--api-rate") == 0 && i + 1 < argc) {
+            apiOptions.requestsPerSecond = std::max(0.0, std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--no-hedge") == 0) {
+            apiOptions.hedge = false;
+        } else if (std::strcmp(argv[i], "--api-cooldown") == 0 && i + 1 < argc) {
+            apiOptions.breakerCooldown = std::chrono::milliseconds(std::max(0, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--bench-api") == 0 && i + 1 < argc) {
+            benchApiRequests = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--stress") == 0 && i + 1 < argc) {
+            stressThreads = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--ops") == 0 && i + 1 < argc) {
+            stressOps = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--bench-writes") == 0 && i + 1 < argc) {
+            benchProducers = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--bench-formats") == 0 && i + 1 < argc) {
+            benchRecipes = std::max(1L, std::atol(argv[++i]));
+        } else if (std::strcmp(argv[i], "--bench-meal-json") == 0 && i + 1 < argc) {
+            benchMealJson = argv[++i];
+        } else if (std::strcmp(argv[i], "--durability") == 0 && i + 1 < argc) {
+            queueOptions.durability = std::strcmp(argv[++i], "normal") == 0 ? WriteQueue::Durability::Normal : WriteQueue::Durability::Full;
+        } else if (std::strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
+            queueOptions.batchWindow = std::chrono::microseconds(std::max(0, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--help") == 0 || std::strcmp(argv[i], "-h") == 0) {
+            printUsage();
+            return 0;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            printUsage();
+            return 2;
+        } else {
+            inputPath = argv[i];
+        }
+    }
+
+    if (benchProducers > 0) {
+        runWriteBenchmark(dbPath, benchProducers, stressOps, queueOptions);
+        return 0;
+    }
+    if (benchRecipes > 0) {
+        runFormatBenchmark(dbPath, static_cast<size_t>(benchRecipes));
+        return 0;
+    }
+    if (!benchMealJson.empty()) {
+        runMealJsonBenchmark(benchMealJson);
+        return 0;
+    }
+    if (benchApiRequests > 0) {
+        return runApiBenchmark(apiOptions, benchApiRequests) ? 0 : 1;
+    }
+    if (stressThreads > 0) {
+        RecipeManager manager(dbPath);
+        return runStress(manager, stressThreads, stressOps) ? 0 : 1;
+    }
+
+    std::ifstream inFile;
+    if (inputPath != "-") {
+        inFile.open(inputPath);
+        if (!inFile) {
+            std::cerr << "Failed to open command file: " << inputPath << std::endl;
+            return 1;
+        }
+    }
+    std::istream &input = (inputPath == "-") ? std::cin : inFile;
+
+    RecipeManager manager(dbPath);
+    manager.setImportThreads(importThreads);
+    manager.setExportThreads(exportThreads);
+    manager.setClearUndoWindow(std::chrono::seconds(undoWindow));
+    manager.configureMealDb(apiOptions);
+    BatchStats stats;
+    auto started = std::chrono::steady_clock::now();
+    {
+        BatchWriter batch(manager, batchSize, stats);
+        std::string line;
+        while (std::getline(input, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+            ++stats.commands;
+            if (!runCommand(manager, batch, stats, line)) {
+                ++stats.failures;
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    std::cerr << stats.commands << " commands (" << stats.writes << " writes, "
+              << stats.failures << " failed) in " << stats.transactions << " transactions, "
+              << seconds << " s, "
+              << (seconds > 0 ? static_cast<double>(stats.commands) / seconds : 0.0) << " commands/s"
+              << std::endl;
+
+    return stats.failures == 0 ? 0 : 1;
+}
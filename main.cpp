@@ -1,10 +1,21 @@
 #include <gtk/gtk.h>
+#include "GUI.h"
 #include "RecipeManager.h"
+#include "StartupProfiler.h"
+#include "ThumbnailCache.h"
+#include <memory>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
-// Global RecipeManager instance
-RecipeManager manager;
+// Globals in this file initialize in order, so this brackets the manager
+static const bool startupBegin = (StartupProfiler::mark("process start"), true);
+
+// Global RecipeManager instance (the database opens later, off the main thread)
+RecipeManager manager("recipes.db", RecipeManager::OpenMode::Deferred);
+
+static const bool managerConstructed = (StartupProfiler::mark("static init: RecipeManager manager"), true);
 
 // Function to load CSS file
 void load_css() {
@@ -151,33 +162,199 @@ void on_view_favorite_recipes_clicked(GtkWidget *widget, gpointer data) {
     gtk_label_set_text(GTK_LABEL(label), favoriteList.c_str());
 }
 
-// Callback to search recipes by ingredient
+// Shared thumbnail loader for search results, created on first use
+static ThumbnailCache &thumbnails() {
+    static ThumbnailCache *cache = new ThumbnailCache(); // Lives until exit
+    return *cache;
+}
+
+// Outcome of saving a TheMealDB recipe, on its way to the main loop
+struct SaveResult {
+    GtkWidget *button;
+    bool saved;
+};
+
+// Show whether the recipe was saved (main thread)
+static gboolean on_remote_recipe_saved(gpointer data) {
+    std::unique_ptr<SaveResult> result(static_cast<SaveResult *>(data));
+    gtk_button_set_label(GTK_BUTTON(result->button), result->saved ? "Saved" : "Save failed");
+    gtk_widget_set_sensitive(result->button, !result->saved);
+    g_object_unref(result->button);
+    return G_SOURCE_REMOVE;
+}
+
+// Callback to save a TheMealDB recipe, ingredients and all, into the local
+// catalog; the lookup runs off the main thread
+static void on_save_remote_clicked(GtkWidget *button, gpointer data) {
+    int mealId = GPOINTER_TO_INT(data);
+    gtk_button_set_label(GTK_BUTTON(button), "Saving...");
+    gtk_widget_set_sensitive(button, FALSE);
+
+    // The row may be destroyed by a newer search before the save finishes
+    g_object_ref(button);
+    std::thread([button, mealId] {
+        g_idle_add(on_remote_recipe_saved, new SaveResult{button, manager.importRemoteRecipe(mealId)});
+    }).detach();
+}
+
+// The row showing a thumbnail went away before the image arrived
+static void on_thumbnail_row_destroyed(GtkWidget *image, gpointer data) {
+    thumbnails().cancel(GPOINTER_TO_SIZE(data));
+}
+
+// Build one search result row; the thumbnail fills in when it has loaded
+static GtkWidget *create_result_row(const Recipe &recipe) {
+    GtkWidget *row = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+
+    GtkWidget *image = gtk_image_new_from_icon_name("image-loading", GTK_ICON_SIZE_DIALOG);
+    gtk_widget_set_size_request(image, 96, 96);
+    gtk_box_pack_start(GTK_BOX(row), image, FALSE, FALSE, 0);
+
+    GtkWidget *label = create_selectable_label(("ID: " + std::to_string(recipe.id) + " - " + recipe.name).c_str());
+    gtk_label_set_xalign(GTK_LABEL(label), 0);
+    gtk_box_pack_start(GTK_BOX(row), label, TRUE, TRUE, 0);
+
+    GtkWidget *saveButton = gtk_button_new_with_label("Save");
+    gtk_widget_set_valign(saveButton, GTK_ALIGN_CENTER);
+    g_signal_connect(saveButton, "clicked", G_CALLBACK(on_save_remote_clicked), GINT_TO_POINTER(recipe.id));
+    gtk_box_pack_start(GTK_BOX(row), saveButton, FALSE, FALSE, 0);
+
+    ThumbnailCache::Ticket ticket = thumbnails().request(recipe.thumbnailUrl, [image](GdkPixbuf *pixbuf) {
+        if (pixbuf) {
+            gtk_image_set_from_pixbuf(GTK_IMAGE(image), pixbuf);
+        } else {
+            gtk_image_set_from_icon_name(GTK_IMAGE(image), "image-missing", GTK_ICON_SIZE_DIALOG);
+        }
+    });
+    // A newer search destroys the row: drop its download if still queued
+    if (ticket) {
+        g_signal_connect(image, "destroy", G_CALLBACK(on_thumbnail_row_destroyed), GSIZE_TO_POINTER(ticket));
+    }
+
+    return row;
+}
+
+// Build one row for a saved recipe found by the search
+static GtkWidget *create_saved_row(const Recipe &recipe) {
+    GtkWidget *row = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+
+    GtkWidget *image = gtk_image_new_from_icon_name("document-open", GTK_ICON_SIZE_DIALOG);
+    gtk_widget_set_size_request(image, 96, 96);
+    gtk_box_pack_start(GTK_BOX(row), image, FALSE, FALSE, 0);
+
+    GtkWidget *label = create_selectable_label(("Saved - " + recipe.name + " (" + recipe.category + ")").c_str());
+    gtk_label_set_xalign(GTK_LABEL(label), 0);
+    gtk_box_pack_start(GTK_BOX(row), label, TRUE, TRUE, 0);
+    return row;
+}
+
+// Results of the search currently shown; a newer search makes older
+// batches stale
+struct SearchView {
+    GtkWidget *resultLabel;
+    GtkWidget *resultList;
+    unsigned generation = 0;
+    size_t shown = 0;
+};
+
+// One batch of search results on its way to the main loop
+struct SearchBatch {
+    SearchView *view;
+    unsigned generation;
+    RecipeManager::SearchSource source;
+    std::vector<Recipe> recipes;
+    bool finished;
+};
+
+// Add a batch of results to the list (main thread)
+static gboolean show_search_batch(gpointer data) {
+    std::unique_ptr<SearchBatch> batch(static_cast<SearchBatch *>(data));
+    SearchView *view = batch->view;
+    if (batch->generation != view->generation) {
+        return G_SOURCE_REMOVE;
+    }
+
+    for (const auto &recipe : batch->recipes) {
+        bool saved = batch->source == RecipeManager::SearchSource::Local;
+        gtk_container_add(GTK_CONTAINER(view->resultList), saved ? create_saved_row(recipe) : create_result_row(recipe));
+    }
+    gtk_widget_show_all(view->resultList);
+    view->shown += batch->recipes.size();
+
+    std::string status = std::to_string(view->shown) + " recipes found";
+    if (!batch->finished) {
+        status += ", searching TheMealDB...";
+    } else if (view->shown == 0) {
+        status = "No recipes found for the given ingredient.";
+    }
+    gtk_label_set_text(GTK_LABEL(view->resultLabel), status.c_str());
+    return G_SOURCE_REMOVE;
+}
+
+// Callback to search saved recipes and TheMealDB; saved recipes show at
+// once and TheMealDB results are added as they arrive
 void on_search_by_ingredient_clicked(GtkWidget *widget, gpointer data) {
     GtkWidget **widgets = (GtkWidget **)data;
     GtkWidget *ingredientEntry = widgets[0];
-    GtkWidget *resultLabel = widgets[1];
+    static SearchView *view = new SearchView{widgets[1], widgets[2]}; // Lives until exit
 
     const char *ingredient = gtk_entry_get_text(GTK_ENTRY(ingredientEntry));
     if (!ingredient || strlen(ingredient) == 0) {
-        gtk_label_set_text(GTK_LABEL(resultLabel), "Please enter an ingredient.");
+        gtk_label_set_text(GTK_LABEL(view->resultLabel), "Please enter an ingredient.");
         return;
     }
 
-    auto recipes = manager.searchByIngredient(ingredient);
-    if (recipes.empty()) {
-        gtk_label_set_text(GTK_LABEL(resultLabel), "No recipes found for the given ingredient.");
+    gtk_container_foreach(GTK_CONTAINER(view->resultList), (GtkCallback)gtk_widget_destroy, NULL);
+    unsigned generation = ++view->generation;
+    view->shown = 0;
+
+    if (strchr(ingredient, ',')) {
+        // "chicken, garlic": TheMealDB recipes with all of them, off the main thread
+        std::vector<std::string> ingredients;
+        std::istringstream list(ingredient);
+        for (std::string item; std::getline(list, item, ',');) {
+            ingredients.push_back(item);
+        }
+        gtk_label_set_text(GTK_LABEL(view->resultLabel), "Searching TheMealDB...");
+        std::thread([generation, ingredients] {
+            auto *batch = new SearchBatch{view, generation, RecipeManager::SearchSource::Remote, manager.searchByIngredients(ingredients), true};
+            g_idle_add(show_search_batch, batch);
+        }).detach();
         return;
     }
 
-    std::string recipeList;
-    for (const auto &recipe : recipes) {
-        recipeList += "ID: " + std::to_string(recipe.id) + " - " + recipe.name + "\n";
-    }
+    manager.searchAll(ingredient, RecipeManager::SearchOptions(),
+                      [generation](RecipeManager::SearchSource source, const std::vector<Recipe> &recipes, bool finished) {
+        auto *batch = new SearchBatch{view, generation, source, recipes, finished};
+        if (source == RecipeManager::SearchSource::Local) {
+            show_search_batch(batch); // Already on the main thread
+        } else {
+            g_idle_add(show_search_batch, batch);
+        }
+    });
+}
 
-    gtk_label_set_text(GTK_LABEL(resultLabel), recipeList.c_str());
+// Instructions fetched for the "Get Instructions" label, on their way to
+// the main loop; only the latest request is shown
+struct InstructionsResult {
+    GtkWidget *label;
+    unsigned request;
+    std::string instructions;
+};
+static unsigned latestInstructionsRequest = 0;
+
+// Show fetched instructions (main thread)
+static gboolean on_instructions_fetched(gpointer data) {
+    std::unique_ptr<InstructionsResult> result(static_cast<InstructionsResult *>(data));
+    if (result->request == latestInstructionsRequest) {
+        gtk_label_set_text(GTK_LABEL(result->label), result->instructions.c_str());
+    }
+    g_object_unref(result->label);
+    return G_SOURCE_REMOVE;
 }
 
-// Callback to fetch recipe instructions by ID
+// Callback to fetch recipe instructions by ID; the fetch runs off the main
+// thread so a slow TheMealDB doesn't freeze the window
 void on_get_instructions_clicked(GtkWidget *widget, gpointer data) {
     GtkWidget **widgets = (GtkWidget **)data;
     GtkWidget *idEntry = widgets[0];
@@ -190,36 +367,32 @@ void on_get_instructions_clicked(GtkWidget *widget, gpointer data) {
     }
 
     int recipeID = std::stoi(recipeIDStr);
-    std::string instructions = manager.getRecipeInstructions(recipeID);
+    unsigned request = ++latestInstructionsRequest;
+    gtk_label_set_text(GTK_LABEL(instructionsLabel), "Loading instructions...");
 
-    gtk_label_set_text(GTK_LABEL(instructionsLabel), instructions.c_str());
+    g_object_ref(instructionsLabel);
+    std::thread([instructionsLabel, request, recipeID] {
+        g_idle_add(on_instructions_fetched, new InstructionsResult{instructionsLabel, request, manager.getRecipeInstructions(recipeID)});
+    }).detach();
 }
 
-// Main application activation function
-static void activate(GtkApplication *app, gpointer user_data) {
-    // Load CSS at activation
-    load_css();
-
-    GtkWidget *window;
-    GtkWidget *grid;
+// Callback to open a recipe ID in the shared viewer window
+void on_open_viewer_clicked(GtkWidget *widget, gpointer data) {
+    GtkWidget *idEntry = GTK_WIDGET(data);
 
-    window = gtk_application_window_new(app);
-    gtk_window_set_title(GTK_WINDOW(window), "Recipe Manager");
-    gtk_window_set_default_size(GTK_WINDOW(window), 800, 600); // Fixed window size
-
-    // Create a scrollable container
-    GtkWidget *scrolledWindow = gtk_scrolled_window_new(NULL, NULL);
-    gtk_container_add(GTK_CONTAINER(window), scrolledWindow);
-
-    // Set the scrolling policy
-    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolledWindow), GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    int recipeID = std::atoi(gtk_entry_get_text(GTK_ENTRY(idEntry)));
+    if (recipeID <= 0) {
+        return;
+    }
 
-    // Create the main grid and attach it to the scrolled window
-    grid = gtk_grid_new();
-    gtk_grid_set_column_spacing(GTK_GRID(grid), 15);
-    gtk_grid_set_row_spacing(GTK_GRID(grid), 15);
-    gtk_container_add(GTK_CONTAINER(scrolledWindow), grid);
+    Recipe recipe;
+    recipe.id = recipeID;
+    recipe.name = "Recipe #" + std::to_string(recipeID);
+    manager.displayRecipeUI(recipe); // The rest of the recipe loads in the background
+}
 
+// Build the "Search Recipes by Ingredient" section
+static void build_search_section(GtkWidget *grid) {
     // Section Header: Search Recipes by Ingredient
     GtkWidget *searchHeader = gtk_label_new(NULL);
     gtk_label_set_markup(GTK_LABEL(searchHeader), "<span font='16' weight='bold'>Search Recipes by Ingredient</span>");
@@ -229,7 +402,7 @@ static void activate(GtkApplication *app, gpointer user_data) {
     gtk_grid_attach(GTK_GRID(grid), searchHeader, 0, 0, 2, 1);
 
     GtkWidget *ingredientEntry = gtk_entry_new();
-    gtk_entry_set_placeholder_text(GTK_ENTRY(ingredientEntry), "Enter Ingredient");
+    gtk_entry_set_placeholder_text(GTK_ENTRY(ingredientEntry), "Enter Ingredient(s), comma-separated");
     gtk_widget_set_size_request(ingredientEntry, 200, 30);
     gtk_grid_attach(GTK_GRID(grid), ingredientEntry, 0, 1, 1, 1);
 
@@ -237,16 +410,25 @@ static void activate(GtkApplication *app, gpointer user_data) {
     gtk_widget_set_size_request(searchButton, 150, 30);
     gtk_grid_attach(GTK_GRID(grid), searchButton, 1, 1, 1, 1);
 
+    GtkWidget *resultBox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+    gtk_widget_set_size_request(resultBox, 600, 200);
+    gtk_grid_attach(GTK_GRID(grid), resultBox, 0, 2, 2, 1);
+
     GtkWidget *resultLabel = gtk_label_new("Results will appear here...");
     gtk_label_set_xalign(GTK_LABEL(resultLabel), 0);
     gtk_label_set_line_wrap(GTK_LABEL(resultLabel), TRUE);
     gtk_label_set_max_width_chars(GTK_LABEL(resultLabel), 70);
-    gtk_widget_set_size_request(resultLabel, 600, 200);
-    gtk_grid_attach(GTK_GRID(grid), resultLabel, 0, 2, 2, 1);
+    gtk_box_pack_start(GTK_BOX(resultBox), resultLabel, FALSE, FALSE, 0);
 
-    GtkWidget **searchWidgets = new GtkWidget *[2]{ingredientEntry, resultLabel};
+    GtkWidget *resultList = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+    gtk_box_pack_start(GTK_BOX(resultBox), resultList, TRUE, TRUE, 0);
+
+    GtkWidget **searchWidgets = new GtkWidget *[3]{ingredientEntry, resultLabel, resultList};
     g_signal_connect(searchButton, "clicked", G_CALLBACK(on_search_by_ingredient_clicked), searchWidgets);
+}
 
+// Build the "Fetch Recipe Instructions" section
+static void build_instructions_section(GtkWidget *grid) {
     // Section Header: Fetch Recipe Instructions
     GtkWidget *instructionsHeader = gtk_label_new(NULL);
     gtk_label_set_markup(GTK_LABEL(instructionsHeader), "<span font='16' weight='bold'>Fetch Recipe Instructions</span>");
@@ -274,6 +456,14 @@ static void activate(GtkApplication *app, gpointer user_data) {
     GtkWidget **instructionWidgets = new GtkWidget *[2]{idEntry, instructionsLabel};
     g_signal_connect(instructionsButton, "clicked", G_CALLBACK(on_get_instructions_clicked), instructionWidgets);
 
+    GtkWidget *viewerButton = gtk_button_new_with_label("Open in Viewer");
+    gtk_widget_set_size_request(viewerButton, 150, 30);
+    gtk_grid_attach(GTK_GRID(grid), viewerButton, 2, 4, 1, 1);
+    g_signal_connect(viewerButton, "clicked", G_CALLBACK(on_open_viewer_clicked), idEntry);
+}
+
+// Build the "Add a Recipe" section
+static void build_add_section(GtkWidget *grid) {
     // Section Header: Add a Recipe
     GtkWidget *addHeader = gtk_label_new(NULL);
     gtk_label_set_markup(GTK_LABEL(addHeader), "<span font='16' weight='bold'>Add a Recipe</span>");
@@ -315,7 +505,10 @@ static void activate(GtkApplication *app, gpointer user_data) {
     gtk_grid_attach(GTK_GRID(grid), addButton, 3, 7, 1, 1);
     GtkWidget **addWidgets = new GtkWidget *[5]{addNameEntry, addIngredientsEntry, categoryDropdown, addInstructionsTextView, addStatusLabel};
     g_signal_connect(addButton, "clicked", G_CALLBACK(on_add_recipe_clicked), addWidgets);
+}
 
+// Build the "View All Recipes" section
+static void build_view_section(GtkWidget *grid) {
     // Section Header: View All Recipes
     GtkWidget *viewHeader = gtk_label_new(NULL);
     gtk_label_set_markup(GTK_LABEL(viewHeader), "<span font='16' weight='bold'>View All Recipes</span>");
@@ -334,7 +527,10 @@ static void activate(GtkApplication *app, gpointer user_data) {
     gtk_widget_set_size_request(viewRecipesButton, 150, 30);
     gtk_grid_attach(GTK_GRID(grid), viewRecipesButton, 3, 11, 1, 1);
     g_signal_connect(viewRecipesButton, "clicked", G_CALLBACK(on_view_recipes_clicked), viewRecipesLabel);
+}
 
+// Build the "Favorite Recipes" section
+static void build_favorites_section(GtkWidget *grid) {
     // Section Header: Favorite Recipes
     GtkWidget *favoriteHeader = gtk_label_new(NULL);
     gtk_label_set_markup(GTK_LABEL(favoriteHeader), "<span font='16' weight='bold'>Favorite Recipes</span>");
@@ -363,7 +559,10 @@ static void activate(GtkApplication *app, gpointer user_data) {
     gtk_widget_set_size_request(viewFavoritesButton, 150, 30);
     gtk_grid_attach(GTK_GRID(grid), viewFavoritesButton, 3, 14, 1, 1);
     g_signal_connect(viewFavoritesButton, "clicked", G_CALLBACK(on_view_favorite_recipes_clicked), viewFavoritesLabel);
+}
 
+// Build the export, import and clear buttons
+static void build_data_section(GtkWidget *grid) {
     // Section: Export, Import, and Clear Database
     GtkWidget *exportButton = gtk_button_new_with_label("Export Recipes");
     gtk_widget_set_size_request(exportButton, 150, 30);
@@ -379,8 +578,67 @@ static void activate(GtkApplication *app, gpointer user_data) {
     gtk_widget_set_size_request(clearButton, 150, 30);
     gtk_grid_attach(GTK_GRID(grid), clearButton, 2, 15, 1, 1);
     g_signal_connect(clearButton, "clicked", G_CALLBACK(on_clear_database_clicked), NULL);
+}
+
+// Build the sections below the fold once the first frame is on screen
+static gboolean build_deferred_sections(gpointer data) {
+    GtkWidget *grid = GTK_WIDGET(data);
+
+    build_add_section(grid);
+    build_view_section(grid);
+    build_favorites_section(grid);
+    build_data_section(grid);
+    gtk_widget_show_all(grid);
+
+    StartupProfiler::mark("deferred sections built");
+    StartupProfiler::report();
+    return G_SOURCE_REMOVE;
+}
+
+// Runs after the main window's first draw
+static gboolean on_first_frame(GtkWidget *widget, cairo_t *cr, gpointer data) {
+    g_signal_handlers_disconnect_by_func(widget, (gpointer)on_first_frame, data);
+    StartupProfiler::mark("first frame");
+    g_idle_add(build_deferred_sections, data);
+    return FALSE;
+}
+
+// Main application activation function
+static void activate(GtkApplication *app, gpointer user_data) {
+    StartupProfiler::mark("activate");
+
+    // Load CSS at activation
+    load_css();
+    StartupProfiler::mark("load_css");
+
+    GtkWidget *window;
+    GtkWidget *grid;
+
+    window = gtk_application_window_new(app);
+    gtk_window_set_title(GTK_WINDOW(window), "Recipe Manager");
+    gtk_window_set_default_size(GTK_WINDOW(window), 800, 600); // Fixed window size
+
+    // Create a scrollable container
+    GtkWidget *scrolledWindow = gtk_scrolled_window_new(NULL, NULL);
+    gtk_container_add(GTK_CONTAINER(window), scrolledWindow);
+
+    // Set the scrolling policy
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolledWindow), GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+
+    // Create the main grid and attach it to the scrolled window
+    grid = gtk_grid_new();
+    gtk_grid_set_column_spacing(GTK_GRID(grid), 15);
+    gtk_grid_set_row_spacing(GTK_GRID(grid), 15);
+    gtk_container_add(GTK_CONTAINER(scrolledWindow), grid);
+
+    // Only the sections visible in the initial 800x600 window are built up
+    // front; the rest are added right after the first frame
+    build_search_section(grid);
+    build_instructions_section(grid);
+    g_signal_connect_after(window, "draw", G_CALLBACK(on_first_frame), grid);
 
     gtk_widget_show_all(window);
+    StartupProfiler::mark("activate: widgets built");
 }
 
 // Main entry point
@@ -388,6 +646,9 @@ int main(int argc, char **argv) {
     GtkApplication *app;
     int status;
 
+    // The database opens on a worker thread while GTK starts up
+    manager.openInBackground();
+
     app = gtk_application_new("com.recipe.manager", G_APPLICATION_DEFAULT_FLAGS);
     g_signal_connect(app, "activate", G_CALLBACK(activate), NULL);
 
@@ -0,0 +1,133 @@
+#!/bin/bash
+# Runs recipe_cli against tools/mealdb_standin.py and checks the TheMealDB
+# scenarios described in the README: thumbnails, hedging, the circuit
+# breaker and resuming the offline mirror. Exits non-zero if any check fails.
+#
+# Usage: tools/check_mealdb.sh [RECIPE_CLI]   (default ./recipe_cli)
+#        PORT=8765 selects the stand-in's port.
+set -u
+cd "$(dirname "$0")/.."
+CLI=$(realpath "${1:-./recipe_cli}")
+PORT=${PORT:-8765}
+WORK=$(mktemp -d)
+export MEALDB_API_URL=http://127.0.0.1:$PORT
+failed=0
+
+python3 tools/mealdb_standin.py "$PORT" > "$WORK/server.log" 2>&1 &
+SERVER=$!
+trap 'kill $SERVER 2>/dev/null; rm -rf "$WORK"' EXIT
+for _ in $(seq 50); do
+    curl -sf "$MEALDB_API_URL/list.php?c=list" > /dev/null && break
+    sleep 0.1
+done
+
+# check NAME CONDITION...: report one result
+check() {
+    local name=$1
+    shift
+    if "$@"; then
+        echo "ok   $name"
+    else
+        echo "FAIL $name"
+        failed=1
+    fi
+}
+
+# stat KEY FILE: value of KEY=VALUE in the last api-stats line of FILE
+stat() {
+    grep '^requests=' "$2" | tail -1 | tr ' ' '\n' | sed -n "s/^$1=//p"
+}
+
+# control QUERY: switch the stand-in's latency profile
+control() {
+    curl -sf "$MEALDB_API_URL/control?$1" > /dev/null
+}
+
+# p99 FILE: p99 in whole milliseconds from --bench-api output
+p99() {
+    awk 'NR == 2 { print int($3) }' "$1"
+}
+
+# synced COUNT_NAME FILE: a count from the sync-mealdb report in FILE
+synced() {
+    grep -o "[0-9]* $1" "$2" | head -1 | cut -d' ' -f1
+}
+
+# mirror N: run sync-mealdb on the mirror database, report in mirrorN.out
+mirror() {
+    echo "sync-mealdb" | "$CLI" --db "$WORK/mirror.db" --api-rate 0 > "$WORK/mirror$1.out" 2>&1
+}
+
+# --- Thumbnails: search results carry thumbnail URLs the server answers
+echo "search ing3" | "$CLI" --db "$WORK/thumbs.db" > "$WORK/search.out" 2>&1
+thumb=$(curl -s "$MEALDB_API_URL/filter.php?i=ing3" | python3 -c 'import json,sys; print(json.load(sys.stdin)["meals"][0]["strMealThumb"])')
+check "search by ingredient returns recipes" grep -q '^ID: 500' "$WORK/search.out"
+check "thumbnail URL serves a PNG" test "$(curl -s "$thumb" | head -c 4 | tail -c 3)" = "PNG"
+
+# --- Hedging: one request in 50 stalls for 0.5 s. Hedged lookups send a
+# second copy after the p95 and keep the p99 near the normal 20 ms.
+control "profile=tail&stall=0.5"
+"$CLI" --api-rate 0 --bench-api 200 > "$WORK/hedged.out" 2>&1
+"$CLI" --api-rate 0 --no-hedge --bench-api 100 > "$WORK/unhedged.out" 2>&1
+check "unhedged p99 waits for the stall" test "$(p99 "$WORK/unhedged.out")" -ge 500
+check "hedged p99 stays under half the stall" test "$(p99 "$WORK/hedged.out")" -lt 250
+check "hedges answer the stalled requests" test "$(stat hedge_wins "$WORK/hedged.out")" -gt 0
+
+# --- Circuit breaker: five failures in a row open it; while open, requests
+# fail at once and repeats get the last good response. After the cooldown a
+# probe closes it again.
+control "profile=normal"
+{
+    for id in 50001 50002 50003 50004 50005; do echo "instructions $id"; done
+    sleep 0.5
+    control "profile=down"
+    for id in 50001 50002 50003 50004 50005 50006; do echo "instructions $id"; done
+    echo "api-stats"
+    sleep 0.5
+    control "profile=normal"
+    sleep 1.2
+    echo "instructions 50007"
+    echo "api-stats"
+} | "$CLI" --db "$WORK/breaker.db" --api-rate 0 --api-cooldown 1000 > "$WORK/breaker.out" 2>&1
+grep '^requests=' "$WORK/breaker.out" | head -1 > "$WORK/open.stats"
+check "breaker opens after 5 failures" test "$(stat breaker "$WORK/open.stats")" = "open"
+check "open breaker rejects requests" test "$(stat rejected "$WORK/open.stats")" -gt 0
+check "outage is answered with the last good responses" test "$(stat stale "$WORK/open.stats")" -ge 5
+check "stale instructions are shown" test "$(grep -c '^Steps' "$WORK/breaker.out")" -ge 10
+check "breaker closes after the cooldown" test "$(stat breaker "$WORK/breaker.out")" = "closed"
+check "probe after recovery succeeds" grep -q '^Steps 7$' "$WORK/breaker.out"
+
+# --- Mirror: an interrupted sync resumes where it stopped, a refresh is
+# answered by 304s, and only the pages of revised meals are downloaded again
+control "profile=normal&fail=cd"
+mirror 1
+check "sync with failing pages is incomplete" grep -q 'Mirror incomplete' "$WORK/mirror1.out"
+check "the failing pages are reported" test "$(synced failed "$WORK/mirror1.out")" -eq 2
+control "fail="
+mirror 2
+check "resumed sync completes" grep -q 'Mirror complete' "$WORK/mirror2.out"
+check "resumed sync skips the pages done before" test "$(synced 'already done' "$WORK/mirror2.out")" -eq 40
+check "resumed sync downloads only the failed pages" test "$(synced 'pages downloaded' "$WORK/mirror2.out")" -eq 2
+mirror 3
+check "refresh finds every page unchanged" test "$(synced unchanged "$WORK/mirror3.out")" -eq 42
+check "refresh writes nothing" test "$(synced 'recipes written' "$WORK/mirror3.out")" -eq 0
+curl -sf "$MEALDB_API_URL/mutate?i=50007" > /dev/null
+curl -sf "$MEALDB_API_URL/mutate?i=50100" > /dev/null
+mirror 4
+check "revised meals' pages are downloaded" test "$(synced 'pages downloaded' "$WORK/mirror4.out")" -eq 2
+check "only the revised meals are written" test "$(synced 'recipes written' "$WORK/mirror4.out")" -eq 2
+echo "instructions 50007" | "$CLI" --db "$WORK/mirror.db" > "$WORK/revised.out" 2>&1
+check "revised instructions are read from the mirror" grep -q '^Steps 7 (revised)$' "$WORK/revised.out"
+
+# A recipe of the user linked by import-remote keeps its content through a sync
+{
+    echo "add Heal 7|my own ingredient|Dinner|My own steps"
+    echo "import-remote 50007"
+    echo "sync-mealdb"
+    echo "instructions 50007"
+    echo "list"
+} | "$CLI" --db "$WORK/linked.db" --api-rate 0 > "$WORK/linked.out" 2>&1
+check "sync leaves a linked recipe of the user alone" grep -q '^My own steps$' "$WORK/linked.out"
+check "linked recipe keeps its ingredients" grep -q '^Heal 7 (Dinner): my own ingredient$' "$WORK/linked.out"
+
+exit $failed
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""Local stand-in for TheMealDB, for checking the app without the network.
+
+Usage: tools/mealdb_standin.py [PORT] [--profile normal|tail|down] [--stall SECONDS] [--fail LETTERS]
+       (default port 8765, profile normal, stall 1.5)
+
+Point the app at it with MEALDB_API_URL=http://127.0.0.1:PORT. It serves a
+fixed catalog of 300 meals (IDs 50001-50300) through search.php, filter.php,
+lookup.php and list.php, and a small PNG thumbnail for each meal under
+/images/. Every request is printed to stdout as "HIT <endpoint> <query>".
+
+The profile shapes the API answers, not the thumbnails:
+  normal  every answer right away
+  tail    every 50th request stalls for --stall seconds, the others take 20 ms
+  down    every request gets 503 Service Unavailable
+GET /control?profile=NAME[&stall=SECONDS][&fail=LETTERS] switches it while
+running.
+
+For mirror syncs, every JSON answer carries an ETag and a request whose
+If-None-Match still matches gets 304 Not Modified. The search.php?f= pages
+of the letters in --fail get 503, and GET /mutate?i=ID revises one meal's
+instructions, which changes the pages that list it.
+"""
+import argparse
+import hashlib
+import http.server
+import json
+import struct
+import threading
+import time
+import urllib.parse
+import zlib
+
+ARGS = argparse.ArgumentParser(description="Local stand-in for TheMealDB")
+ARGS.add_argument("port", nargs="?", type=int, default=8765)
+ARGS.add_argument("--profile", choices=["normal", "tail", "down"], default="normal")
+ARGS.add_argument("--stall", type=float, default=1.5)
+ARGS.add_argument("--fail", default="", help="letters whose search.php?f= page gets 503")
+OPTIONS = ARGS.parse_args()
+PORT = OPTIONS.port
+BASE = "http://127.0.0.1:%d" % PORT
+CATEGORIES = ["Beef", "Chicken", "Dessert", "Vegan"]
+LETTERS = "abcdefghijklmnopqrstuvwxyz"
+
+
+def make_meal(number):
+    meal_id = str(50000 + number)
+    # Every 50th name starts with '#', so it is only reachable by category
+    name = "%seal %d" % (LETTERS[number % 26].upper(), number) if number % 50 else "#%d Special" % number
+    meal = {
+        "idMeal": meal_id,
+        "strMeal": name,
+        "strDrinkAlternate": None,
+        "strCategory": CATEGORIES[number % 4],
+        "strArea": "Unknown",
+        "strInstructions": "Steps %d" % number,
+        "strMealThumb": "%s/images/%s.png" % (BASE, meal_id),
+        "strTags": None,
+        "strYoutube": "",
+    }
+    for k in range(1, 21):
+        used = k <= 1 + number % 5
+        meal["strIngredient%d" % k] = "Ing%d" % ((number * k) % 40) if used else ""
+        meal["strMeasure%d" % k] = "%d g" % (k * 10) if used else " "
+    return meal
+
+
+MEALS = {m["idMeal"]: m for m in (make_meal(n) for n in range(1, 301))}
+LOCK = threading.Lock()
+PROFILE = {"name": OPTIONS.profile, "stall": OPTIONS.stall, "fail": OPTIONS.fail.lower(), "requests": 0}
+
+
+def summary(meal):
+    return {"idMeal": meal["idMeal"], "strMeal": meal["strMeal"], "strMealThumb": meal["strMealThumb"]}
+
+
+def ingredients(meal):
+    return {meal["strIngredient%d" % k].lower() for k in range(1, 21) if meal["strIngredient%d" % k]}
+
+
+def png(seed):
+    """An 8x8 single-colour PNG."""
+    def chunk(kind, data):
+        return struct.pack(">I", len(data)) + kind + data + struct.pack(">I", zlib.crc32(kind + data) & 0xFFFFFFFF)
+    pixel = bytes([seed * 37 % 256, seed * 91 % 256, seed * 53 % 256])
+    rows = b"".join(b"\x00" + pixel * 8 for _ in range(8))
+    return (b"\x89PNG\r\n\x1a\n" + chunk(b"IHDR", struct.pack(">IIBBBBB", 8, 8, 8, 2, 0, 0, 0)) +
+            chunk(b"IDAT", zlib.compress(rows)) + chunk(b"IEND", b""))
+
+
+def answer(endpoint, query):
+    """JSON document for an API endpoint."""
+    meals = list(MEALS.values())
+    if endpoint == "search.php" and "f" in query:
+        found = [m for m in meals if m["strMeal"][0].lower() == query["f"].lower()]
+    elif endpoint == "search.php":
+        found = [m for m in meals if query.get("s", "").lower() in m["strMeal"].lower()]
+    elif endpoint == "filter.php" and "c" in query:
+        found = [summary(m) for m in meals if m["strCategory"] == query["c"]]
+    elif endpoint == "filter.php":
+        wanted = query.get("i", "").replace("_", " ").lower()
+        found = [summary(m) for m in meals if wanted in ingredients(m)]
+    elif endpoint == "lookup.php":
+        found = [MEALS[query["i"]]] if query.get("i") in MEALS else []
+    elif endpoint == "list.php":
+        found = [{"strCategory": c} for c in CATEGORIES]
+    else:
+        found = []
+    return {"meals": found or None}
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    def log_message(self, *args):
+        pass
+
+    def send(self, status, body=b"", content_type="application/json", etag=None):
+        self.send_response(status)
+        if etag:
+            self.send_header("ETag", etag)
+        if status != 304:
+            self.send_header("Content-Type", content_type)
+            self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_GET(self):
+        url = urllib.parse.urlparse(self.path)
+        query = {k: v[0] for k, v in urllib.parse.parse_qs(url.query, keep_blank_values=True).items()}
+        endpoint = url.path.rsplit("/", 1)[-1]
+
+        if endpoint == "control":
+            with LOCK:
+                PROFILE["name"] = query.get("profile", PROFILE["name"])
+                PROFILE["stall"] = float(query.get("stall", PROFILE["stall"]))
+                PROFILE["fail"] = query.get("fail", PROFILE["fail"]).lower()
+                body = json.dumps(PROFILE).encode()
+            print("CONTROL", url.query, flush=True)
+            return self.send(200, body)
+        if endpoint == "mutate":
+            with LOCK:
+                found = query.get("i") in MEALS
+                if found:
+                    MEALS[query["i"]]["strInstructions"] += " (revised)"
+            print("MUTATE", url.query, flush=True)
+            return self.send(200 if found else 404, json.dumps({"ok": found}).encode())
+        print("HIT", endpoint, url.query, flush=True)
+
+        if url.path.startswith("/images/"):
+            meal_id = endpoint.split(".")[0]
+            if meal_id not in MEALS:
+                return self.send(404)
+            return self.send(200, png(int(meal_id)), "image/png")
+        with LOCK:
+            PROFILE["requests"] += 1
+            profile, count, stall = PROFILE["name"], PROFILE["requests"], PROFILE["stall"]
+            failing = endpoint == "search.php" and query.get("f", "").lower() in set(PROFILE["fail"])
+            body = json.dumps(answer(endpoint, query)).encode()
+        if profile == "down" or failing:
+            return self.send(503)
+        if profile == "tail":
+            time.sleep(stall if count % 50 == 0 else 0.02)
+        etag = '"%s"' % hashlib.md5(body).hexdigest()
+        if self.headers.get("If-None-Match") == etag:
+            return self.send(304, etag=etag)
+        self.send(200, body, etag=etag)
+
+
+if __name__ == "__main__":
+    http.server.ThreadingHTTPServer(("127.0.0.1", PORT), Handler).serve_forever()